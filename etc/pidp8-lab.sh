@@ -0,0 +1,59 @@
+#! /bin/sh
+
+# Start a lab of headless PiDP-8 machines, all in one pidp8-lab process.
+#
+#   pidp8-lab.sh start n [script [baseport]]
+#   pidp8-lab.sh stop
+#   pidp8-lab.sh status
+#
+# pidp8-lab runs machine i (0 .. n-1) as "pidp8 -n script baseport+i i" on a thread of its
+# own, pinned to core i modulo the number of cores, in screen session pidp8-lab. -n leaves
+# the front panel to the main pidp8, so the lab can run beside it. Each machine has its own
+# memory, devices, clock queue, console port (telnet to baseport+i) and scratch disk; the
+# OS/8 system cartridge is attached with ATTACH -p, so all machines share the one image
+# read only and each keeps its writes to itself. See src/lab.c.
+
+pidp="/opt/pidp8/bin/pidp8-lab"
+script="/opt/pidp8/bootscripts/lab.script"
+baseport=2300
+
+pidp_dir=`dirname $pidp`
+
+test -x /usr/bin/screen || { echo "screen not found"; exit 1; }
+test -x $pidp || { echo "pidp8-lab not found"; exit 1; }
+
+do_start() {
+	n=$1
+	test -n "$2" && script=$2
+	test -n "$3" && baseport=$3
+	mkdir -p $pidp_dir/../imagefiles/lab
+	screen -dmS pidp8-lab $pidp $n $script $baseport
+	echo "pidp8-lab: $n machines, telnet ports $baseport .. $((baseport + n - 1))"
+}
+
+do_stop() {
+	for s in `screen -ls | egrep -o '[0-9]+\.pidp8-lab'`; do
+		screen -S $s -X stuff "^C"
+	done
+}
+
+case "$1" in
+  start)
+	test -n "$2" || { echo "Usage: $0 start n [script [baseport]]"; exit 1; }
+	do_start $2 $3 $4
+	;;
+
+  stop)
+	do_stop
+	;;
+
+  status)
+	screen -ls | egrep '[0-9]+\.pidp8-lab'
+	;;
+
+  *)
+	echo "Usage: $0 {start n [script [baseport]]|stop|status}"
+	exit 1
+esac
+
+exit 0
@@ -145,7 +145,8 @@ int32 t;
 
 dev_done = dev_done | INT_CLK;                          /* set done */
 int_req = INT_UPDATE;                                   /* update interrupts */
-t = sim_rtcn_calb (clk_tps, TMR_CLK);                   /* calibrate clock */
+t = rr_mode? rr_calb (clk_tps, TMR_CLK):                /* calibrate clock */
+    sim_rtcn_calb (clk_tps, TMR_CLK);
 tmxr_poll = t;                                          /* set mux poll */
 sim_activate_after (uptr, 1000000/clk_tps);             /* reactivate unit */
 return SCPE_OK;
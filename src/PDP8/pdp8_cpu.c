@@ -188,6 +188,11 @@
 */
 
 #include "pdp8_defs.h"
+#include "pdp8_shm.h"
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
 
 #define PCQ_SIZE        64                              /* must be 2**n */
 #define PCQ_MASK        (PCQ_SIZE - 1)
@@ -196,11 +201,48 @@
 #define UNIT_NOEAE      (1 << UNIT_V_NOEAE)
 #define UNIT_V_MSIZE    (UNIT_V_UF + 1)                 /* dummy mask */
 #define UNIT_MSIZE      (1 << UNIT_V_MSIZE)
+#define UNIT_V_THRD     (UNIT_V_UF + 2)                 /* threaded dispatch */
+#define UNIT_THRD       (1 << UNIT_V_THRD)
+#define UNIT_V_SBLK     (UNIT_V_UF + 3)                 /* superblocks */
+#define UNIT_SBLK       (1 << UNIT_V_SBLK)
+#define UNIT_V_GLOW     (UNIT_V_UF + 4)                 /* incandescent panel */
+#define UNIT_GLOW       (1 << UNIT_V_GLOW)
+#define UNIT_V_STATS    (UNIT_V_UF + 5)                 /* execution counts */
+#define UNIT_STATS      (1 << UNIT_V_STATS)
+#define UNIT_V_REAL     (UNIT_V_UF + 6)                 /* real time pacing */
+#define UNIT_REAL       (1 << UNIT_V_REAL)
 #define OP_KSF          06031                           /* for idle */
+#define IDLE_MAXW       4                               /* max loop before JMP */
+#define IDLE_MAXSIG     16                              /* max signatures */
+
+#if defined (__GNUC__)                                  /* labels as values? */
+#define CPU_THREADED    1
+#endif
+#define MEM_PUT(x,d)    ((pdc[x].blk? sb_inval (x): 0), \
+                         pdc[x].op = PDC_MISS, M[x] = (uint16) (d)) /* write, invalidate */
+#define MEM_WR(x,d)     (((watch & SWMASK ('W'))? cpu_watch (x, SWMASK ('W')): 0), \
+                         MEM_PUT (x, d))                /* watched write */
+#define MEM_RD(x)       (((watch & SWMASK ('R'))? cpu_watch (x, SWMASK ('R')): 0), \
+                         M[x])                          /* watched read */
+#define WATCH_SPC       (1u << SIM_BKPT_V_SPC)          /* watchpoint space */
+
+#define PDC_MISS        0                               /* not yet decoded */
+#define PDC_IOT         031                             /* IOT */
+#define PDC_OPR1        032                             /* OPR group 1 */
+#define PDC_OPR2        033                             /* OPR group 2 */
+#define PDC_OPR3        034                             /* OPR group 3 */
+#define SB_MAX          64                              /* max superblock length */
+#define SW_PANEL        07760                           /* panel command switches */
+#define SW_BUSY         1                               /* never a swpub seq value */
+#define LED_ONREQ       0x7FFFFFFF                      /* LEDINT = 0 count */
+#define OPR_SKST(x)     ((((x) >> 9) & 04) | ((((x) & 07777) == 0) << 1) | \
+                         ((x) >> 12))                   /* skip state */
 
 #define HIST_PC         0x40000000
 #define HIST_MIN        64
 #define HIST_MAX        65536
+#define HFILE_MAX       (1 << 26)                       /* ring file entries */
+#define HFILE_DFLT      (1 << 20)
 
 typedef struct {
     int32               pc;
@@ -211,7 +253,90 @@ typedef struct {
     int16               mq;
     } InstHistory;
 
-uint16 M[MAXMEMSIZE] = { 0 };                           /* main memory */
+/* History ring file.  The ring is the InstHistory array itself, mapped
+   from a file behind this header, so recording into it costs the same as
+   recording into memory.  The pointer is written after every record, so
+   the file can be decoded while it is being recorded into, or after the
+   simulator died; entries not yet written have HIST_PC clear. */
+
+#define HFILE_MAGIC     "PDP8HST"
+
+typedef struct {
+    char                magic[8];                       /* HFILE_MAGIC */
+    uint32              rsize;                          /* record size */
+    uint32              lnt;                            /* ring length */
+    uint32              p;                              /* last record */
+    uint32              spare;
+    } HistFile;
+
+/* Idle loop signatures.  A signature gives the words of a loop ahead of the
+   JMP that closes it, as value/mask pairs, and the interrupt state in which
+   the loop can only be left by an event: bits of int_req that must be set,
+   and bits that must be clear.  Signatures are tried on backward direct
+   jumps of up to IDLE_MAXW words, when idling is enabled. */
+
+typedef struct {
+    char                name[16];
+    int32               need;                           /* int_req set */
+    int32               clr;                            /* int_req clear */
+    int32               lnt;                            /* words before JMP */
+    uint16              val[IDLE_MAXW];
+    uint16              mask[IDLE_MAXW];
+    t_uint64            hits;                           /* times matched */
+    } IDLESIG;
+
+/* Real time pacing.  Instructions are charged their PDP-8/I execution time,
+   in units of 0.25us: 1.5us per memory cycle, so 6 for a fetch, 6 more for
+   an execute cycle and 6 more for a defer cycle.  An IOT takes 4.25us.
+   Autoindexing is done within the defer cycle, and ISZ within its execute
+   cycle, at no extra cost.  EAE instructions that fetch a second word take
+   a cycle more; MUY and DVI take 8.25us.  Every RTBATCH us of machine time
+   execution is paced against the host's monotonic clock.  Device timing is
+   still counted in instructions. */
+
+#define RT_UNIT         250                             /* ns per unit */
+#define RT_SLIP         20000000                        /* max ns behind */
+
+static const uint8 rt_cost[32] = {
+    12, 12, 18, 18, 12, 12, 18, 18,                     /* AND, TAD */
+    12, 12, 18, 18, 12, 12, 18, 18,                     /* ISZ, DCA */
+    12, 12, 18, 18,  6,  6, 12, 12,                     /* JMS, JMP */
+    17, 17, 17, 17,  6,  6,  6,  6                      /* IOT, OPR */
+    };
+static const uint8 rt_eae[8] = {                        /* EAE, over OPR */
+     0,  6, 27, 27,  0,  6,  6,  6                      /* SCL..LSR */
+    };
+
+/* Predecoded instruction cache.  There is one entry per word of memory,
+   so the cache is organised as eight 4K fields, just like M.  An entry
+   holds the threaded handler index for the instruction in that word (the
+   decode point plus one for memory reference instructions) and, for AND,
+   TAD, ISZ and DCA, the precomputed direct address.  Every write to memory
+   clears the entry; memory written by SCP, the loaders or the bootstraps is
+   covered by flushing the whole cache on entry to sim_instr.
+
+   The cache also records superblocks.  A superblock is a straight-line run
+   of AND, TAD, DCA, OPR group 1 and non-EAE OPR group 3 instructions, ended
+   by one instruction of any other kind (typically ISZ, JMP or a skip).  The
+   entry for the first word holds the block length, and every word inside a
+   block is flagged, so that a write to it discards the blocks covering it. */
+
+typedef struct {
+    uint16              op;                             /* handler index */
+    uint16              ea;                             /* direct address */
+    uint8               sbl;                            /* superblock length */
+    uint8               blk;                            /* in superblock */
+    } PDCENT;
+
+/* Main memory.  M points at mem_home, or at the memory part of the
+   shared segment while SET CPU SHM is in effect.  Device registers which
+   are memory words (the DF32, RF08 and TC08 word count and address) are
+   declared on mem_home, and follow M when it moves (see mem_move). */
+
+#define MEM_BYTES       (MAXMEMSIZE * sizeof (uint16))
+
+uint16 mem_home[MAXMEMSIZE] = { 0 };                    /* own memory */
+uint16 *M = mem_home;                                   /* main memory */
 int32 saved_LAC = 0;                                    /* saved L'AC */
 int32 saved_MQ = 0;                                     /* saved MQ */
 int32 saved_PC = 0;                                     /* saved IF'PC */
@@ -239,6 +364,31 @@ int32 (*dev_tab[DEV_MAX])(int32 IR, int32 dat);         /* device dispatch */
 int32 hst_p = 0;                                        /* history pointer */
 int32 hst_lnt = 0;                                      /* history length */
 InstHistory *hst = NULL;                                /* instruction history */
+HistFile *hst_map = NULL;                               /* history ring file */
+char hst_fname[CBUFSIZE];                               /* ring file name */
+SHM_HDR *shm_map = NULL;                                /* shared segment */
+char shm_name[CBUFSIZE];                                /* segment name */
+int32 led_ivl = 1;                                      /* panel sample interval */
+uint32 watch_hit = 0;                                   /* watchpoint taken */
+int32 rt_batch = 250;                                   /* pacing interval, us */
+struct timespec rt_base;                                /* pacing start */
+t_uint64 rt_ns = 0;                                     /* machine time since */
+PDCENT pdc[MAXMEMSIZE];                                 /* predecode cache */
+OPRDEC opr_dec[01000];                                  /* decoded OPR */
+t_uint64 cst_op[32];                                    /* counts by decode point */
+t_uint64 cst_iot[DEV_MAX];                              /* IOTs by device */
+t_uint64 cst_opr[01000];                                /* OPRs by microcode */
+t_uint64 cst_int = 0;                                   /* interrupts taken */
+t_uint64 cst_idle = 0;                                  /* idle calls */
+IDLESIG idle_sig[IDLE_MAXSIG] = {
+    { "KSF", 0, INT_ION|INT_TTI, 1,                     /* OS/8 keyboard wait */
+      { OP_KSF }, { 07777 } },
+    { "JMP", INT_ION, INT_ALL, 0 },                     /* TSS/8 null job */
+    { "ETOS", INT_ION, INT_ALL, 3,                      /* ETOS V5B idle job: */
+      { 00251, 00251, 02034 }, { 07777, 07777, 07777 } }, /* AND .-1; AND .-2; ISZ 34 */
+    { "FOCAL", INT_ION, INT_ALL, 2,                     /* FOCAL input: TAD, skip */
+      { 01000, 07400 }, { 07400, 07407 } }
+    };
 
 extern int32 sim_interval;
 extern int32 sim_int_char;
@@ -248,8 +398,10 @@ extern FILE *sim_log;
 extern t_bool sim_idle_enab;
 
 /* ------------------------------------------------------------------------------------------------- */
-extern uint32 switchstatus[3]; // bitfields: 3 rows of up to 12 switches
-extern uint32 ledstatus[8];	// bitfields: 8 ledrows of up to 12 LEDs
+#include "gpio.h"	// panel state shared with gpio.c
+uint32 switchstatus[3] = { 0 }; // bitfields: 3 rows of up to 12 switches, copy of swpub
+uint32 ledstatus[8] = { 0 };	// bitfields: 8 ledrows of up to 12 LEDs, published to ledpub
+ledacc_t *ledacc;		// GLOW frame being accumulated, in glowpub
 void setleds(uint32 sPC, uint32 sMA, uint16 sMB, int32 sLAC, int32 sMQ, int32 sIF, int32 sDF);
 /* ------------------------------------------------------------------------------------------------- */
 /* --------------------------------------------------------------------------------------------------------- */
@@ -275,9 +427,37 @@ t_stat cpu_ex (t_value *vptr, t_addr addr, UNIT *uptr, int32 sw);
 t_stat cpu_dep (t_value val, t_addr addr, UNIT *uptr, int32 sw);
 t_stat cpu_reset (DEVICE *dptr);
 t_stat cpu_set_size (UNIT *uptr, int32 val, char *cptr, void *desc);
+t_stat cpu_set_thrd (UNIT *uptr, int32 val, char *cptr, void *desc);
+t_stat cpu_set_stats (UNIT *uptr, int32 val, char *cptr, void *desc);
+t_stat cpu_clr_stats (UNIT *uptr, int32 val, char *cptr, void *desc);
+t_stat cpu_show_stats (FILE *st, UNIT *uptr, int32 val, void *desc);
+void cpu_count (int32 IR);
+int32 cpu_watch (uint32 pa, uint32 typ);
+int32 eae_nmi_ref (int32 lm);
+t_stat cpu_eaecheck_cmd (int32 flag, char *cptr);
+void rt_pace (int32 q);
+t_bool idle_match (uint32 pa, int32 lnt);
+t_stat cpu_set_isig (UNIT *uptr, int32 val, char *cptr, void *desc);
+t_stat cpu_clr_isig (UNIT *uptr, int32 val, char *cptr, void *desc);
+t_stat cpu_show_isig (FILE *st, UNIT *uptr, int32 val, void *desc);
 t_stat cpu_set_hist (UNIT *uptr, int32 val, char *cptr, void *desc);
 t_stat cpu_show_hist (FILE *st, UNIT *uptr, int32 val, void *desc);
+t_stat cpu_set_hfile (UNIT *uptr, int32 val, char *cptr, void *desc);
+t_stat cpu_clr_hfile (UNIT *uptr, int32 val, char *cptr, void *desc);
+t_stat cpu_show_hfile (FILE *st, UNIT *uptr, int32 val, void *desc);
+t_stat cpu_hdump_cmd (int32 flag, char *cptr);
+t_stat cpu_set_shm (UNIT *uptr, int32 val, char *cptr, void *desc);
+t_stat cpu_clr_shm (UNIT *uptr, int32 val, char *cptr, void *desc);
+t_stat cpu_show_shm (FILE *st, UNIT *uptr, int32 val, void *desc);
+void shm_put (int32 pc, int32 df, int32 lac, int32 mq, int32 run);
+void mem_move (uint16 *to);
+void hst_free (void);
+void hst_fprint (FILE *st, InstHistory *h);
 t_bool build_dev_tab (void);
+void pdc_fill (uint32 ma);
+void opr_build (void);
+void sb_build (uint32 ma);
+int32 sb_inval (uint32 pa);
 
 /* CPU data structures
 
@@ -316,14 +496,31 @@ REG cpu_reg[] = {
     { ORDATA (PCQP, pcq_p, 6), REG_HRO },
     { FLDATA (STOP_INST, stop_inst, 0) },
     { ORDATA (WRU, sim_int_char, 8) },
+    { DRDATA (LEDINT, led_ivl, 24), PV_LEFT },
+    { DRDATA (RTBATCH, rt_batch, 24), PV_LEFT },
     { NULL }
     };
 
 MTAB cpu_mod[] = {
     { UNIT_NOEAE, UNIT_NOEAE, "no EAE", "NOEAE", NULL },
     { UNIT_NOEAE, 0, "EAE", "EAE", NULL },
+    { UNIT_THRD, UNIT_THRD, "threaded dispatch", "THREADED", &cpu_set_thrd },
+    { UNIT_THRD, 0, "switch dispatch", "SWITCH", NULL },
+    { UNIT_SBLK, UNIT_SBLK, "superblocks", "SUPERBLOCK", &cpu_set_thrd },
+    { UNIT_SBLK, 0, NULL, "NOSUPERBLOCK", NULL },
+    { UNIT_GLOW, UNIT_GLOW, "incandescent panel", "GLOW", NULL },
+    { UNIT_GLOW, 0, NULL, "NOGLOW", NULL },
+    { UNIT_REAL, UNIT_REAL, "real time", "REALTIME", NULL },
+    { UNIT_REAL, 0, NULL, "NOREALTIME", NULL },
+    { UNIT_STATS, UNIT_STATS, "statistics", NULL, NULL },
+    { MTAB_XTD|MTAB_VDV|MTAB_VALO|MTAB_NMO, 0, "STATS", "STATS",
+      &cpu_set_stats, &cpu_show_stats },
+    { MTAB_XTD|MTAB_VDV, 0, NULL, "NOSTATS", &cpu_clr_stats, NULL },
     { MTAB_XTD|MTAB_VDV, 0, "IDLE", "IDLE", &sim_set_idle, &sim_show_idle },
     { MTAB_XTD|MTAB_VDV, 0, NULL, "NOIDLE", &sim_clr_idle, NULL },
+    { MTAB_XTD|MTAB_VDV|MTAB_NMO, 0, "IDLESIG", "IDLESIG",
+      &cpu_set_isig, &cpu_show_isig },
+    { MTAB_XTD|MTAB_VDV, 0, NULL, "NOIDLESIG", &cpu_clr_isig, NULL },
     { UNIT_MSIZE, 4096, NULL, "4K", &cpu_set_size },
     { UNIT_MSIZE, 8192, NULL, "8K", &cpu_set_size },
     { UNIT_MSIZE, 12288, NULL, "12K", &cpu_set_size },
@@ -334,6 +531,12 @@ MTAB cpu_mod[] = {
     { UNIT_MSIZE, 32768, NULL, "32K", &cpu_set_size },
     { MTAB_XTD|MTAB_VDV|MTAB_NMO|MTAB_SHP, 0, "HISTORY", "HISTORY",
       &cpu_set_hist, &cpu_show_hist },
+    { MTAB_XTD|MTAB_VDV|MTAB_NMO|MTAB_NC, 0, "HFILE", "HFILE",
+      &cpu_set_hfile, &cpu_show_hfile },
+    { MTAB_XTD|MTAB_VDV, 0, NULL, "NOHFILE", &cpu_clr_hfile, NULL },
+    { MTAB_XTD|MTAB_VDV|MTAB_NMO|MTAB_NC, 0, "SHM", "SHM",
+      &cpu_set_shm, &cpu_show_shm },
+    { MTAB_XTD|MTAB_VDV, 0, NULL, "NOSHM", &cpu_clr_shm, NULL },
     { 0 }
     };
 
@@ -345,12 +548,55 @@ DEVICE cpu_dev = {
     NULL, 0
     };
 
+/* EAE normalize shift count, for L'AC'MQ in lm.  AC'MQ is shifted left
+   until its top two bits differ, or its low 22 bits are zero: up to the
+   highest bit that differs from the bit below it, or until the lowest
+   one reaches bit 22, whichever comes first.  eae_nmi_ref is the bit by
+   bit original, kept as the reference. */
+
+static inline int32 eae_nmi (int32 lm)
+{
+#if defined (__GNUC__)
+uint32 v = (uint32) lm & 077777777;
+int32 sd, sz;
+
+if (v == 0)
+    return 0;
+sd = __builtin_clz ((v ^ (v << 1)) & 077777777) - 8;   /* top bits differ */
+sz = 22 - __builtin_ctz (v);                            /* low bits zero */
+if (sz < 0)
+    sz = 0;
+return (sz < sd)? sz: sd;
+#else
+return eae_nmi_ref (lm);
+#endif
+}
+
 t_stat sim_instr (void)
 {
 int32 IR, MB, IF, DF, LAC, MQ;
 uint32 PC, MA;
 int32 device, pulse, temp, iot_data;
+int32 sb_left = 0;
+uint32 sw_gen = SW_BUSY;
+int32 led_cnt = 0;
+OPRDEC *opd;
+int32 rt_acc = 0, rt_lim;
+uint32 watch;
+t_bool stats, hooks;
 t_stat reason;
+#if defined (CPU_THREADED)
+static void *const op_disp[] = {                        /* handler dispatch */
+    NULL,
+    &&and_dz, &&and_dc, &&and_iz, &&and_ic,
+    &&tad_dz, &&tad_dc, &&tad_iz, &&tad_ic,
+    &&isz_dz, &&isz_dc, &&isz_iz, &&isz_ic,
+    &&dca_dz, &&dca_dc, &&dca_iz, &&dca_ic,
+    &&jms_dz, &&jms_dc, &&jms_iz, &&jms_ic,
+    &&jmp_dz, &&jmp_dc, &&jmp_iz, &&jmp_ic,
+    &&iot, &&opr_g1, &&opr_g2, &&opr_g3
+    };
+#endif
 
 /* Restore register state */
 
@@ -362,11 +608,43 @@ LAC = saved_LAC & 017777;
 MQ = saved_MQ & 07777;
 int_req = INT_UPDATE;
 reason = 0;
+stats = (cpu_unit.flags & UNIT_STATS) != 0;             /* counting? */
+rt_lim = 0;
+if ((cpu_unit.flags & UNIT_REAL) && (rt_batch > 0)) {   /* pacing? */
+    rt_lim = rt_batch * (1000 / RT_UNIT);
+    rt_pace (-1);                                       /* start now */
+    }
+hooks = stats || rt_lim;
+watch = sim_brk_summ & (SWMASK ('R') | SWMASK ('W'));   /* watchpoints? */
+watch_hit = 0;                                          /* none taken yet */
+if (shm_map)                                            /* exporting? */
+    shm_put (IF | PC, DF, LAC, MQ, 1);
+
+/* Threaded dispatch.  The handler for each word of memory is found in the
+   predecode cache, so an instruction is decoded once, when it is first
+   executed, rather than on every execution.  The handlers are the decode
+   points of the switch below, entered with MA already set to the direct
+   address, plus separate entries for the three operate groups; the switch
+   remains the reference path.
+
+   With superblocks enabled as well, a fetch that lands on the start of a
+   superblock runs the whole block without returning to the top of this
+   loop: sim_interval is charged once for the block, the panel is sampled
+   once, and interrupts, breakpoints and front panel switches are checked
+   before the block is entered rather than between its instructions.  None
+   of the instructions ahead of the last one can change the interrupt state
+   or transfer control, so the result is the same as executing them one by
+   one.  A block is only entered if all of its instructions fit before the
+   next event, so device timing is unchanged. */
+
+memset (pdc, 0, sizeof (pdc));                          /* flush predecode */
 
 
 /* ---PiDP add--------------------------------------------------------------------------------------------- */
 int swDevice;
 char sScript[256];
+ledglow = (cpu_unit.flags & UNIT_GLOW) != 0;	// tell the panel whether to expect GLOW frames
+ledacc = panel_next(&glowpub.seq, glowpub.buf, sizeof(glowpub.buf[0]));
 MA = 0;	// have to add this to avoid crash when stop switch is set at start - MA would be undefined in setleds
 setleds(PC, MA, MB, LAC, MQ, IF, DF); // note MB used // light up leds for 1st time, only needed when stop switch set at start
 /* ---PiDP end---------------------------------------------------------------------------------------------- */
@@ -385,13 +663,32 @@ ledstatus[5] &= ~(1<<2); // clear execute
 /* ---PiDP end---------------------------------------------------------------------------------------------- */
 
 
+    AIO_CHECK_EVENT;                                    /* async I/O done? */
     if (sim_interval <= 0) {                            /* check clock queue */
+        if (shm_map)                                    /* exporting? */
+            shm_put (IF | PC, DF, LAC, MQ, 1);
         if (reason = sim_process_event ())
             break;
         }
 
 /* ---PiDP add--------------------------------------------------------------------------------------------- */
 
+// gpio.c publishes swpub, with a new seq, whenever a row of switches changes. If nothing changed since
+// the last scan, no command switch was down then and the CPU is running, there is
+// nothing to do. Otherwise scan, and keep scanning (sw_gen = SW_BUSY never matches)
+// for as long as a command switch is down or the CPU is stopped.
+// When a run is recorded, switch changes are logged as they are read. When one is replayed,
+// the rows come from the log instead of the panel, on every pass.
+
+if (sw_gen == PANEL_SEQ(swpub))			// panel unchanged and idle
+	goto swIdle;
+if (rr_mode != RR_PLAY)
+	sw_gen = panel_read(&swpub.seq, swpub.buf, sizeof(swpub.buf[0]), switchstatus);	// all rows, consistent
+if (rr_mode && (reason = rr_panel(switchstatus)))	// log, or replay, switch changes
+	break;
+if (((switchstatus[2] & SW_PANEL) != SW_PANEL) || swStop || (rr_mode == RR_PLAY))
+	sw_gen = SW_BUSY;				// switch down, stopped or replaying: keep scanning
+
 // this bit of code detects SING_INST as the special features switch.
 // when DF switches are set, that raises a hacked-in-to-simh signal to ATTACH PTR <filename>
 // when IF switches are set, that raises a hacked-in-to-simh signal to DO <filename> (boot script)
@@ -439,13 +736,14 @@ if ((switchstatus[2] & 0x0020)==0) //SING_STEP toggled
 		}
 
 		// 3. Scan for shutdown command (Sing_Step + Sing_inst + Start)
+		//    (this and the other host commands below are not run when replaying a recorded run)
 
 		if (((switchstatus[2] & 0x0800)==0) && ((switchstatus[2] & 0x0010)==0))
 		{
 			printf("\r\nShutdown\r\n\r\n");
 			reason = STOP_HALT;
 			awfulHackFlag = 8;	// this triggers an exit command after leaving the simulator run. 
-			if(spawn_cmd ((int32) 0, " shutdown -h -t 1 now")!=SCPE_OK)		// issue simh attach command (no sudo in buildroot)
+			if((rr_mode != RR_PLAY) && (spawn_cmd ((int32) 0, " shutdown -h -t 1 now")!=SCPE_OK))		// issue simh attach command (no sudo in buildroot)
 				printf("\r\n\n\nshutdown failed\r\n\n");
 		}
 
@@ -456,7 +754,7 @@ if ((switchstatus[2] & 0x0020)==0) //SING_STEP toggled
 			printf("\r\nReboot\r\n\r\n");
 			reason = STOP_HALT;
 			awfulHackFlag = 8;      // this triggers an exit command after leaving the simulator run. 
-			if(spawn_cmd ((int32) 0, " reboot")!=SCPE_OK) {// no sudo in buildroot env
+			if((rr_mode != RR_PLAY) && (spawn_cmd ((int32) 0, " reboot")!=SCPE_OK)) {// no sudo in buildroot env
 				printf("\r\n\n\nreboot failed\r\n\n");
 			}
 		}
@@ -467,7 +765,7 @@ if ((switchstatus[2] & 0x0020)==0) //SING_STEP toggled
 		if ((switchstatus[2] & 0x0410)==0)
 		{
 			printf("\r\nMount\r\n\r\n");
-			if(spawn_cmd ((int32) 0, " /opt/pidp8/bin/automount")!=SCPE_OK) {// no sudo in buildroot env
+			if((rr_mode != RR_PLAY) && (spawn_cmd ((int32) 0, " /opt/pidp8/bin/automount")!=SCPE_OK)) {// no sudo in buildroot env
 				printf("\r\n\n\nmount USB drive failed\r\n\n");
 			}
 		}
@@ -477,7 +775,7 @@ if ((switchstatus[2] & 0x0020)==0) //SING_STEP toggled
 		if ((switchstatus[2] & 0x0210)==0)
 		{
 			printf("\r\nUnmount\r\n\r\n");
-			if(spawn_cmd ((int32) 0, " /opt/pidp8/bin/unmount")!=SCPE_OK) {// no sudo in buildroot env
+			if((rr_mode != RR_PLAY) && (spawn_cmd ((int32) 0, " /opt/pidp8/bin/unmount")!=SCPE_OK)) {// no sudo in buildroot env
 				printf("\r\n\n\nunmount failed\r\n\n");
 			}
 		}
@@ -537,7 +835,7 @@ if ((switchstatus[2] & 0x0400)==0)			// LOAD_ADD switch activated
 
 if ((switchstatus[2] & 0x0200)==0)			// DEP switch activated
 {	if (swDep==0)
-	{	M[PC] = switchstatus[0] ^ 07777;
+	{	MEM_PUT (PC, switchstatus[0] ^ 07777);
 		/* ??? in 66 handbook: strictly speaking, SR goes into AC, then AC into MB. Does it clear AC afterwards? If not, needs fix */
 		MB = M[PC];
 		MA = PC & 07777;			// 20150315: MA trails PC on FP
@@ -569,25 +867,57 @@ if (swStop==1)
 							// WARNING: THIS MAY LEAD TO TROUBLE. MAYBE?
 	goto skip;					// a goto is period correct methinks
 }
+swIdle:	;
 
 /* ---PiDP end---------------------------------------------------------------------------------------------- */
 
 
+    if (watch_hit) {                                    /* watchpoint taken? */
+        reason = (watch_hit & SWMASK ('W'))? STOP_WBKPT: STOP_RBKPT;
+        watch_hit = 0;                                  /* stop before intr */
+        break;
+        }
+
     if (int_req > INT_PENDING) {                        /* interrupt? */
         int_req = int_req & ~INT_ION;                   /* interrupts off */
         SF = (UF << 6) | (IF >> 9) | (DF >> 12);        /* form save field */
         IF = IB = DF = UF = UB = 0;                     /* clear mem ext */
         PCQ_ENTRY;                                      /* save old PC */
-        M[0] = PC;                                      /* save PC in 0 */
+        MEM_WR (0, PC);                                 /* save PC in 0 */
         PC = 1;                                         /* fetch next from 1 */
+        cst_int++;
         }
 
     MA = IF | PC;                                       /* form PC */
-    if (sim_brk_summ && sim_brk_test (MA, SWMASK ('E'))) { /* breakpoint? */
-        reason = STOP_IBKPT;                            /* stop simulation */
-        break;
+    if (sim_brk_summ) {                                 /* any breakpoints? */
+        if (sim_brk_test (MA, SWMASK ('E'))) {          /* breakpoint? */
+            reason = STOP_IBKPT;                        /* stop simulation */
+            break;
+            }
 	}
 
+#if defined (CPU_THREADED)
+    if (((cpu_unit.flags & (UNIT_THRD|UNIT_SBLK|UNIT_REAL)) == (UNIT_THRD|UNIT_SBLK)) &&
+        (hst_lnt == 0) && (sim_brk_summ == 0) &&        /* no history, bkpts, */
+        (sw_gen == PANEL_SEQ (swpub)) &&                /* panel switches, */
+        ((int_req | INT_NO_ION_PENDING) <= INT_PENDING)) { /* or intr? */
+        if (pdc[MA].sbl == 0)                           /* not looked at yet? */
+            sb_build (MA);
+        if ((pdc[MA].sbl > 1) && (sim_interval >= pdc[MA].sbl)) {
+            led_cnt = led_cnt - pdc[MA].sbl;            /* sample once */
+            if ((led_cnt <= 0) || ledreq) {
+                led_cnt = led_ivl? led_ivl: LED_ONREQ;
+                setleds (PC, MA, M[MA], LAC, MQ, IF, DF);
+                }
+            sb_left = pdc[MA].sbl;
+            sim_interval = sim_interval - sb_left;      /* charge whole block */
+            AIO_CHECK_EVENTS (sb_left - 1);             /* and async I/O checks */
+            int_req = int_req | INT_NO_ION_PENDING;     /* clear ION delay */
+            goto sb_step;
+            }
+        }
+#endif
+
     IR = M[MA];                                         /* fetch instruction */
 
 //PC increment was moved down before, bad idea? now is where it originally was.
@@ -600,9 +930,17 @@ if (swStop==1)
 
 /* ---PiDP add--------------------------------------------------------------------------------------------- */
 
-setleds(PC, MA, M[MA], LAC, MQ, IF, DF); // note M[MA] used not MB
+// The panel is sampled every LEDINT instructions, at the start of every display frame
+// (ledreq), and on every pass while a command switch is down. LEDINT = 1 samples every
+// instruction; LEDINT = 0 samples only when the panel asks for a frame. In STOP mode the
+// panel is refreshed on every pass by the stop mode code above.
+
+if ((--led_cnt <= 0) || ledreq || (sw_gen == SW_BUSY))
+{	led_cnt = led_ivl? led_ivl: LED_ONREQ;
+	setleds(PC, MA, M[MA], LAC, MQ, IF, DF); // note M[MA] used not MB
+}
 
-if  ((switchstatus[2] & 0x040)==0)  		// STOP switch activated
+if  ((sw_gen == SW_BUSY) && ((switchstatus[2] & 0x040)==0))	// STOP switch activated
 {	swStop = 1;
 	goto skip;	
 }
@@ -620,7 +958,7 @@ contPoint:	;	// goto here if CONT has been pressed to finish current instruction
 
 // SING_STEP: swStop=0 if we're here. If SingStep then this time, let it go but trigger a stop on the next pass
 
-if ((switchstatus[2] & 0x0010)==0)		// SING_INST switch activated
+if ((sw_gen == SW_BUSY) && ((switchstatus[2] & 0x0010)==0))	// SING_INST switch activated
 {	if (swSingStep==0)		// allow it this time,
 		swSingStep=1;		// but note to block it next time!
 	else				// else: this is the next time...
@@ -685,102 +1023,159 @@ ledstatus[5] &= ~(1<<3); // clear fetch
             hst[hst_p].ea = ea;                         /* save eff addr */
             hst[hst_p].opnd = M[ea];                    /* save operand */
             }
+        if (hst_map)                                    /* ring file? */
+            hst_map->p = hst_p;                         /* record is complete */
+        }
+    if (hooks) {                                        /* counting, pacing? */
+        if (stats)
+            cpu_count (IR);
+        if (rt_lim) {
+            rt_acc = rt_acc + rt_cost[(IR >> 7) & 037];
+            if ((IR & 07401) == 07401)                  /* EAE? */
+                rt_acc = rt_acc + rt_eae[(IR >> 1) & 07];
+            if (rt_acc >= rt_lim) {                     /* batch done? */
+                rt_pace (rt_acc);
+                rt_acc = 0;
+                }
+            }
         }
 
+#if defined (CPU_THREADED)
+    if (cpu_unit.flags & UNIT_THRD) {                   /* threaded dispatch? */
+        if (pdc[MA].op == PDC_MISS)                     /* not decoded yet? */
+            pdc_fill (MA);
+        temp = pdc[MA].op;
+        MA = pdc[MA].ea;                                /* direct address */
+        goto *op_disp[temp];
+
+/* Superblock step.  If a write has invalidated the word ahead, the rest of
+   the block is abandoned, its charge refunded, and the word is refetched
+   through the normal path. */
+
+    sb_step:
+        MA = IF | PC;                                   /* form PC */
+        temp = pdc[MA].op;
+        if (temp == PDC_MISS) {                         /* written? */
+            sim_interval = sim_interval + sb_left;      /* refund rest */
+            sb_left = 0;
+            continue;
+            }
+        sb_left = sb_left - 1;
+        IR = M[MA];                                     /* fetch instruction */
+        PC = (PC + 1) & 07777;                          /* increment PC */
+        if (stats)                                      /* statistics? */
+            cpu_count (IR);
+        MA = pdc[MA].ea;                                /* direct address */
+        goto *op_disp[temp];
+        }
+#endif
+
 switch ((IR >> 7) & 037) {                              /* decode IR<0:4> */
 
 /* Opcode 0, AND */
 
     case 000:                                           /* AND, dir, zero */
         MA = IF | (IR & 0177);                          /* dir addr, page zero */
-        LAC = LAC & (M[MA] | 010000);
+    and_dz:
+        LAC = LAC & (MEM_RD (MA) | 010000);
         break;
 
     case 001:                                           /* AND, dir, curr */
         MA = (MA & 077600) | (IR & 0177);               /* dir addr, curr page */
-        LAC = LAC & (M[MA] | 010000);
+    and_dc:
+        LAC = LAC & (MEM_RD (MA) | 010000);
         break;
 
     case 002:                                           /* AND, indir, zero */
         MA = IF | (IR & 0177);                          /* dir addr, page zero */
+    and_iz:
         if ((MA & 07770) != 00010)                      /* indirect; autoinc? */
-            MA = DF | M[MA];
-        else MA = DF | (M[MA] = (M[MA] + 1) & 07777);   /* incr before use */
-        LAC = LAC & (M[MA] | 010000);
+            MA = DF | MEM_RD (MA);
+        else MA = DF | MEM_WR (MA, (MEM_RD (MA) + 1) & 07777); /* incr before use */
+        LAC = LAC & (MEM_RD (MA) | 010000);
         break;
 
     case 003:                                           /* AND, indir, curr */
         MA = (MA & 077600) | (IR & 0177);               /* dir addr, curr page */
+    and_ic:
         if ((MA & 07770) != 00010)                      /* indirect; autoinc? */
-            MA = DF | M[MA];
-        else MA = DF | (M[MA] = (M[MA] + 1) & 07777);   /* incr before use */
-        LAC = LAC & (M[MA] | 010000);
+            MA = DF | MEM_RD (MA);
+        else MA = DF | MEM_WR (MA, (MEM_RD (MA) + 1) & 07777); /* incr before use */
+        LAC = LAC & (MEM_RD (MA) | 010000);
         break;
 
 /* Opcode 1, TAD */
 
     case 004:                                           /* TAD, dir, zero */
         MA = IF | (IR & 0177);                          /* dir addr, page zero */
-        LAC = (LAC + M[MA]) & 017777;
+    tad_dz:
+        LAC = (LAC + MEM_RD (MA)) & 017777;
         break;
 
     case 005:                                           /* TAD, dir, curr */
         MA = (MA & 077600) | (IR & 0177);               /* dir addr, curr page */
-        LAC = (LAC + M[MA]) & 017777;
+    tad_dc:
+        LAC = (LAC + MEM_RD (MA)) & 017777;
         break;
 
     case 006:                                           /* TAD, indir, zero */
         MA = IF | (IR & 0177);                          /* dir addr, page zero */
+    tad_iz:
         if ((MA & 07770) != 00010)                      /* indirect; autoinc? */
-            MA = DF | M[MA];
-        else MA = DF | (M[MA] = (M[MA] + 1) & 07777);   /* incr before use */
-        LAC = (LAC + M[MA]) & 017777;
+            MA = DF | MEM_RD (MA);
+        else MA = DF | MEM_WR (MA, (MEM_RD (MA) + 1) & 07777); /* incr before use */
+        LAC = (LAC + MEM_RD (MA)) & 017777;
         break;
 
     case 007:                                           /* TAD, indir, curr */
         MA = (MA & 077600) | (IR & 0177);               /* dir addr, curr page */
+    tad_ic:
         if ((MA & 07770) != 00010)                      /* indirect; autoinc? */
-            MA = DF | M[MA];
-        else MA = DF | (M[MA] = (M[MA] + 1) & 07777);   /* incr before use */
-        LAC = (LAC + M[MA]) & 017777;
+            MA = DF | MEM_RD (MA);
+        else MA = DF | MEM_WR (MA, (MEM_RD (MA) + 1) & 07777); /* incr before use */
+        LAC = (LAC + MEM_RD (MA)) & 017777;
         break;
 
 /* Opcode 2, ISZ */
 
     case 010:                                           /* ISZ, dir, zero */
         MA = IF | (IR & 0177);                          /* dir addr, page zero */
-        M[MA] = MB = (M[MA] + 1) & 07777;               /* field must exist */
+    isz_dz:
+        MEM_WR (MA, MB = (MEM_RD (MA) + 1) & 07777);     /* field must exist */
         if (MB == 0)
             PC = (PC + 1) & 07777;
         break;
 
     case 011:                                           /* ISZ, dir, curr */
         MA = (MA & 077600) | (IR & 0177);               /* dir addr, curr page */
-        M[MA] = MB = (M[MA] + 1) & 07777;               /* field must exist */
+    isz_dc:
+        MEM_WR (MA, MB = (MEM_RD (MA) + 1) & 07777);     /* field must exist */
         if (MB == 0)
             PC = (PC + 1) & 07777;
         break;
 
     case 012:                                           /* ISZ, indir, zero */
         MA = IF | (IR & 0177);                          /* dir addr, page zero */
+    isz_iz:
         if ((MA & 07770) != 00010)                      /* indirect; autoinc? */
-            MA = DF | M[MA];
-        else MA = DF | (M[MA] = (M[MA] + 1) & 07777);   /* incr before use */
-        MB = (M[MA] + 1) & 07777;
+            MA = DF | MEM_RD (MA);
+        else MA = DF | MEM_WR (MA, (MEM_RD (MA) + 1) & 07777); /* incr before use */
+        MB = (MEM_RD (MA) + 1) & 07777;
         if (MEM_ADDR_OK (MA))
-            M[MA] = MB;
+            MEM_WR (MA, MB);
         if (MB == 0)
             PC = (PC + 1) & 07777;
         break;
 
     case 013:                                           /* ISZ, indir, curr */
         MA = (MA & 077600) | (IR & 0177);               /* dir addr, curr page */
+    isz_ic:
         if ((MA & 07770) != 00010)                      /* indirect; autoinc? */
-            MA = DF | M[MA];
-        else MA = DF | (M[MA] = (M[MA] + 1) & 07777);   /* incr before use */
-        MB = (M[MA] + 1) & 07777;
+            MA = DF | MEM_RD (MA);
+        else MA = DF | MEM_WR (MA, (MEM_RD (MA) + 1) & 07777); /* incr before use */
+        MB = (MEM_RD (MA) + 1) & 07777;
         if (MEM_ADDR_OK (MA))
-            M[MA] = MB;
+            MEM_WR (MA, MB);
         if (MB == 0)
             PC = (PC + 1) & 07777;
         break;
@@ -789,33 +1184,37 @@ switch ((IR >> 7) & 037) {                              /* decode IR<0:4> */
 
     case 014:                                           /* DCA, dir, zero */
         MA = IF | (IR & 0177);                          /* dir addr, page zero */
-        M[MA] = LAC & 07777;
+    dca_dz:
+        MEM_WR (MA, LAC & 07777);
         LAC = LAC & 010000;
         break;
 
     case 015:                                           /* DCA, dir, curr */
         MA = (MA & 077600) | (IR & 0177);               /* dir addr, curr page */
-        M[MA] = LAC & 07777;
+    dca_dc:
+        MEM_WR (MA, LAC & 07777);
         LAC = LAC & 010000;
         break;
 
     case 016:                                           /* DCA, indir, zero */
         MA = IF | (IR & 0177);                          /* dir addr, page zero */
+    dca_iz:
         if ((MA & 07770) != 00010)                      /* indirect; autoinc? */
-            MA = DF | M[MA];
-        else MA = DF | (M[MA] = (M[MA] + 1) & 07777);   /* incr before use */
+            MA = DF | MEM_RD (MA);
+        else MA = DF | MEM_WR (MA, (MEM_RD (MA) + 1) & 07777); /* incr before use */
         if (MEM_ADDR_OK (MA))
-            M[MA] = LAC & 07777;
+            MEM_WR (MA, LAC & 07777);
         LAC = LAC & 010000;
         break;
 
     case 017:                                           /* DCA, indir, curr */
         MA = (MA & 077600) | (IR & 0177);               /* dir addr, curr page */
+    dca_ic:
         if ((MA & 07770) != 00010)                      /* indirect; autoinc? */
-            MA = DF | M[MA];
-        else MA = DF | (M[MA] = (M[MA] + 1) & 07777);   /* incr before use */
+            MA = DF | MEM_RD (MA);
+        else MA = DF | MEM_WR (MA, (MEM_RD (MA) + 1) & 07777); /* incr before use */
         if (MEM_ADDR_OK (MA))
-            M[MA] = LAC & 07777;
+            MEM_WR (MA, LAC & 07777);
         LAC = LAC & 010000;
         break;
 
@@ -830,6 +1229,7 @@ switch ((IR >> 7) & 037) {                              /* decode IR<0:4> */
    as usual. */
 
     case 020:                                           /* JMS, dir, zero */
+    jms_dz:
         PCQ_ENTRY;
         MA = IR & 0177;                                 /* dir addr, page zero */
         if (UF) {                                       /* user mode? */
@@ -846,12 +1246,13 @@ switch ((IR >> 7) & 037) {                              /* decode IR<0:4> */
             int_req = int_req | INT_NO_CIF_PENDING;     /* clr intr inhibit */
             MA = IF | MA;
             if (MEM_ADDR_OK (MA))
-                M[MA] = PC;
+                MEM_WR (MA, PC);
             }
         PC = (MA + 1) & 07777;
         break;
 
     case 021:                                           /* JMS, dir, curr */
+    jms_dc:
         PCQ_ENTRY;
         MA = (MA & 007600) | (IR & 0177);               /* dir addr, curr page */
         if (UF) {                                       /* user mode? */
@@ -868,17 +1269,18 @@ switch ((IR >> 7) & 037) {                              /* decode IR<0:4> */
             int_req = int_req | INT_NO_CIF_PENDING;     /* clr intr inhibit */
             MA = IF | MA;
             if (MEM_ADDR_OK (MA))
-                M[MA] = PC;
+                MEM_WR (MA, PC);
             }
         PC = (MA + 1) & 07777;
         break;
 
     case 022:                                           /* JMS, indir, zero */
+    jms_iz:
         PCQ_ENTRY;
         MA = IF | (IR & 0177);                          /* dir addr, page zero */
         if ((MA & 07770) != 00010)                      /* indirect; autoinc? */
-            MA = M[MA];
-        else MA = (M[MA] = (M[MA] + 1) & 07777);        /* incr before use */
+            MA = MEM_RD (MA);
+        else MA = MEM_WR (MA, (MEM_RD (MA) + 1) & 07777); /* incr before use */
         if (UF) {                                       /* user mode? */
             tsc_ir = IR;                                /* save instruction */
             tsc_cdf = 0;                                /* clear flag */
@@ -893,17 +1295,18 @@ switch ((IR >> 7) & 037) {                              /* decode IR<0:4> */
             int_req = int_req | INT_NO_CIF_PENDING;     /* clr intr inhibit */
             MA = IF | MA;
             if (MEM_ADDR_OK (MA))
-                M[MA] = PC;
+                MEM_WR (MA, PC);
             }
         PC = (MA + 1) & 07777;
         break;
 
     case 023:                                           /* JMS, indir, curr */
+    jms_ic:
         PCQ_ENTRY;
         MA = (MA & 077600) | (IR & 0177);               /* dir addr, curr page */
         if ((MA & 07770) != 00010)                      /* indirect; autoinc? */
-            MA = M[MA];
-        else MA = (M[MA] = (M[MA] + 1) & 07777);        /* incr before use */
+            MA = MEM_RD (MA);
+        else MA = MEM_WR (MA, (MEM_RD (MA) + 1) & 07777); /* incr before use */
         if (UF) {                                       /* user mode? */
             tsc_ir = IR;                                /* save instruction */
             tsc_cdf = 0;                                /* clear flag */
@@ -918,7 +1321,7 @@ switch ((IR >> 7) & 037) {                              /* decode IR<0:4> */
             int_req = int_req | INT_NO_CIF_PENDING;     /* clr intr inhibit */
             MA = IF | MA;
             if (MEM_ADDR_OK (MA))
-                M[MA] = PC;
+                MEM_WR (MA, PC);
             }
         PC = (MA + 1) & 07777;
         break;
@@ -932,6 +1335,7 @@ switch ((IR >> 7) & 037) {                              /* decode IR<0:4> */
 
 
     case 024:                                           /* JMP, dir, zero */
+    jmp_dz:
         PCQ_ENTRY;
         MA = IR & 0177;                                 /* dir addr, page zero */
         if (UF) {                                       /* user mode? */
@@ -951,6 +1355,7 @@ switch ((IR >> 7) & 037) {                              /* decode IR<0:4> */
 /* If JMP direct, also check for idle (KSF/JMP *-1) and infinite loop */
 
     case 025:                                           /* JMP, dir, curr */
+    jmp_dc:
         PCQ_ENTRY;
         MA = (MA & 007600) | (IR & 0177);               /* dir addr, curr page */
         if (UF) {                                       /* user mode? */
@@ -963,17 +1368,13 @@ switch ((IR >> 7) & 037) {                              /* decode IR<0:4> */
             }
         if (sim_idle_enab &&                            /* idling enabled? */
             (IF == IB)) {                               /* to same bank? */
-            if (MA == ((PC - 2) & 07777)) {             /* 1) JMP *-1? */
-                if (!(int_req & (INT_ION|INT_TTI)) &&   /*    iof, TTI flag off? */
-                    (M[IB|((PC - 2) & 07777)] == OP_KSF)) /*  next is KSF? */
-                    sim_idle (TMR_CLK, FALSE);          /* we're idle */
-                }                                       /* end JMP *-1 */
-            else if (MA == ((PC - 1) & 07777)) {        /* 2) JMP *? */
-                if (!(int_req & INT_ION))               /*    iof? */
-                    reason = STOP_LOOP;                 /* then infinite loop */
-                else if (!(int_req & INT_ALL))          /*    ion, not intr? */
-                    sim_idle (TMR_CLK, FALSE);          /* we're idle */
-                }                                       /* end JMP */
+            temp = (int32) ((PC - 1) & 07777) - (int32) MA; /* words before JMP */
+            if ((temp == 0) && !(int_req & INT_ION))    /* JMP * with iof? */
+                reason = STOP_LOOP;                     /* then infinite loop */
+            else if ((temp >= 0) && (temp <= IDLE_MAXW) && /* short backward, */
+                idle_match (IB | MA, temp))             /* known idle loop? */
+                cst_idle += rr_mode? rr_idle (TMR_CLK): /* we're idle */
+                    sim_idle (TMR_CLK, FALSE);
             }                                           /* end idle enabled */
         IF = IB;                                        /* change IF */
         UF = UB;                                        /* change UF */
@@ -982,11 +1383,12 @@ switch ((IR >> 7) & 037) {                              /* decode IR<0:4> */
         break;
 
     case 026:                                           /* JMP, indir, zero */
+    jmp_iz:
         PCQ_ENTRY;
         MA = IF | (IR & 0177);                          /* dir addr, page zero */
         if ((MA & 07770) != 00010)                      /* indirect; autoinc? */
-            MA = M[MA];
-        else MA = (M[MA] = (M[MA] + 1) & 07777);        /* incr before use */
+            MA = MEM_RD (MA);
+        else MA = MEM_WR (MA, (MEM_RD (MA) + 1) & 07777); /* incr before use */
         if (UF) {                                       /* user mode? */
             tsc_ir = IR;                                /* save instruction */
             tsc_cdf = 0;                                /* clear flag */
@@ -1002,11 +1404,12 @@ switch ((IR >> 7) & 037) {                              /* decode IR<0:4> */
         break;
 
     case 027:                                           /* JMP, indir, curr */
+    jmp_ic:
         PCQ_ENTRY;
         MA = (MA & 077600) | (IR & 0177);               /* dir addr, curr page */
         if ((MA & 07770) != 00010)                      /* indirect; autoinc? */
-            MA = M[MA];
-        else MA = (M[MA] = (M[MA] + 1) & 07777);        /* incr before use */
+            MA = MEM_RD (MA);
+        else MA = MEM_WR (MA, (MEM_RD (MA) + 1) & 07777); /* incr before use */
         if (UF) {                                       /* user mode? */
             tsc_ir = IR;                                /* save instruction */
             tsc_cdf = 0;                                /* clear flag */
@@ -1024,83 +1427,18 @@ switch ((IR >> 7) & 037) {                              /* decode IR<0:4> */
 /* Opcode 7, OPR group 1 */
 
     case 034:case 035:                                  /* OPR, group 1 */
-        switch ((IR >> 4) & 017) {                      /* decode IR<4:7> */
-        case 0:                                         /* nop */
-            break;
-        case 1:                                         /* CML */
-            LAC = LAC ^ 010000;
-            break;
-        case 2:                                         /* CMA */
-            LAC = LAC ^ 07777;
-            break;
-        case 3:                                         /* CMA CML */
-            LAC = LAC ^ 017777;
-            break;
-        case 4:                                         /* CLL */
-            LAC = LAC & 07777;
-            break;
-        case 5:                                         /* CLL CML = STL */
-            LAC = LAC | 010000;
-            break;
-        case 6:                                         /* CLL CMA */
-            LAC = (LAC ^ 07777) & 07777;
-            break;
-        case 7:                                         /* CLL CMA CML */
-            LAC = (LAC ^ 07777) | 010000;
-            break;
-        case 010:                                       /* CLA */
-            LAC = LAC & 010000;
-            break;
-        case 011:                                       /* CLA CML */
-            LAC = (LAC & 010000) ^ 010000;
-            break;
-        case 012:                                       /* CLA CMA = STA */
-            LAC = LAC | 07777;
-            break;
-        case 013:                                       /* CLA CMA CML */
-            LAC = (LAC | 07777) ^ 010000;
-            break;
-        case 014:                                       /* CLA CLL */
-            LAC = 0;
-            break;
-        case 015:                                       /* CLA CLL CML */
-            LAC = 010000;
-            break;
-        case 016:                                       /* CLA CLL CMA */
-            LAC = 07777;
-            break;
-        case 017:                                       /* CLA CLL CMA CML */
-            LAC = 017777;
-            break;
-            }                                           /* end switch opers */
-
-        if (IR & 01)                                    /* IAC */
-            LAC = (LAC + 1) & 017777;
-        switch ((IR >> 1) & 07) {                       /* decode IR<8:10> */
-        case 0:                                         /* nop */
-            break;
-        case 1:                                         /* BSW */
-            LAC = (LAC & 010000) | ((LAC >> 6) & 077) | ((LAC & 077) << 6);
-            break;
-        case 2:                                         /* RAL */
-            LAC = ((LAC << 1) | (LAC >> 12)) & 017777;
-            break;
-        case 3:                                         /* RTL */
-            LAC = ((LAC << 2) | (LAC >> 11)) & 017777;
-            break;
-        case 4:                                         /* RAR */
-            LAC = ((LAC >> 1) | (LAC << 12)) & 017777;
-            break;
-        case 5:                                         /* RTR */
-            LAC = ((LAC >> 2) | (LAC << 11)) & 017777;
-            break;
-        case 6:                                         /* RAL RAR - undef */
-            LAC = LAC & (IR | 010000);                  /* uses AND path */
-            break;
-        case 7:                                         /* RTL RTR - undef */
-            LAC = (LAC & 010000) | (MA & 07600) | (IR & 0177);
-            break;                                      /* uses address path */
-            }                                           /* end switch shifts */
+    opr_g1:
+        opd = &opr_dec[IR & 0777];                      /* decoded microcode */
+        LAC = (((LAC & opd->andm) ^ opd->xorm) + opd->iac) & 017777;
+        if (opd->rot != 0) {                            /* rotate? */
+            if (opd->rot < OPR_BSW)                     /* RAL, RTL, RAR, RTR */
+                LAC = ((LAC << opd->rot) | (LAC >> (13 - opd->rot))) & 017777;
+            else if (opd->rot == OPR_BSW)               /* BSW */
+                LAC = (LAC & 010000) | ((LAC >> 6) & 077) | ((LAC & 077) << 6);
+            else if (opd->rot == OPR_RALR)              /* RAL RAR - undef */
+                LAC = LAC & (IR | 010000);              /* uses AND path */
+            else LAC = (LAC & 010000) | (MA & 07600) | (IR & 0177);
+            }                                           /* RTL RTR, addr path */
         break;                                          /* end group 1 */
 
 /* OPR group 2.  From Bernhard Baehr's description of the TSC8-75:
@@ -1111,78 +1449,18 @@ switch ((IR >> 7) & 037) {                              /* decode IR<0:4> */
 
     case 036:case 037:                                  /* OPR, groups 2, 3 */
         if ((IR & 01) == 0) {                           /* group 2 */
-            switch ((IR >> 3) & 017) {                  /* decode IR<6:8> */
-            case 0:                                     /* nop */
-                break;
-            case 1:                                     /* SKP */
+        opr_g2:
+            opd = &opr_dec[IR & 0777];                  /* decoded microcode */
+            if ((opd->skp >> OPR_SKST (LAC)) & 1)       /* skip? */
                 PC = (PC + 1) & 07777;
-                break;
-            case 2:                                     /* SNL */
-                if (LAC >= 010000)
-                    PC = (PC + 1) & 07777;
-                break;
-            case 3:                                     /* SZL */
-                if (LAC < 010000)
-                    PC = (PC + 1) & 07777;
-                break;
-            case 4:                                     /* SZA */
-                if ((LAC & 07777) == 0)
-                    PC = (PC + 1) & 07777;
-                break;
-            case 5:                                     /* SNA */
-                if ((LAC & 07777)
-                    != 0) PC = (PC + 1) & 07777;
-                break;
-            case 6:                                     /* SZA | SNL */
-                if ((LAC == 0) || (LAC >= 010000))
-                    PC = (PC + 1) & 07777;
-                break;
-            case 7:                                     /* SNA & SZL */
-                if ((LAC != 0) && (LAC < 010000))
-                    PC = (PC + 1) & 07777;
-                break;
-            case 010:                                   /* SMA */
-                if ((LAC & 04000) != 0)
-                    PC = (PC + 1) & 07777;
-                break;
-            case 011:                                   /* SPA */
-                if ((LAC & 04000) == 0)
-                    PC = (PC + 1) & 07777;
-                break;
-            case 012:                                   /* SMA | SNL */
-                if (LAC >= 04000)
-                    PC = (PC + 1) & 07777;
-                break;
-            case 013:                                   /* SPA & SZL */
-                if (LAC < 04000)
-                    PC = (PC + 1) & 07777;
-                break;
-            case 014:                                   /* SMA | SZA */
-                if (((LAC & 04000) != 0) || ((LAC & 07777) == 0))
-                    PC = (PC + 1) & 07777;
-                break;
-            case 015:                                   /* SPA & SNA */
-                if (((LAC & 04000) == 0) && ((LAC & 07777) != 0))
-                    PC = (PC + 1) & 07777;
-                break;
-            case 016:                                   /* SMA | SZA | SNL */
-                if ((LAC >= 04000) || (LAC == 0))
-                    PC = (PC + 1) & 07777;
-                break;
-            case 017:                                   /* SPA & SNA & SZL */
-                if ((LAC < 04000) && (LAC != 0))
-                    PC = (PC + 1) & 07777;
-                break;
-                }                                       /* end switch skips */
-            if (IR & 0200)                              /* CLA */
-                LAC = LAC & 010000;
-            if ((IR & 06) && UF) {                      /* user mode? */
+            LAC = LAC & opd->andm;                      /* CLA */
+            if ((opd->flg & (OPR_OSR | OPR_HLT)) && UF) { /* user mode? */
                 int_req = int_req | INT_UF;             /* request intr */
                 tsc_ir = IR;                            /* save instruction */
                 tsc_cdf = 0;                            /* clear flag */
                 }
             else {
-                if (IR & 04){                           /* OSR */
+                if (opd->flg & OPR_OSR) {               /* OSR */
 //--- PiDP bug fix 20150822----------------------------------------------------------------
 //OSR never got updated when PDP-8 is running
 //separate bug, not fixed yet: OSR should be updated by DEP and LOAD_ADD switch handlers I think
@@ -1192,13 +1470,14 @@ switch ((IR >> 7) & 037) {                              /* decode IR<0:4> */
  		    OSR = switchstatus[0] ^ 07777;
                     LAC = LAC | OSR;
 		}
-                if (IR & 02)                            /* HLT */
+                if (opd->flg & OPR_HLT) {               /* HLT */
 //--- PiDP change--------------------------------------------------------------------------
 //                    reason = STOP_HALT;
 //-----------------------------------------------------------------------------------------
-			swStop=1;	// don't step out of simulation, just do STOP
+                    swStop = 1;                         /* don't step out of simulation, just do STOP */
+                    sw_gen = SW_BUSY;                   /* and have the panel scan pick it up */
 //--- end of PiDP change--------------------------------------------------------------------------
-
+                    }
                 }
             break;
             }                                           /* end if group 2 */
@@ -1212,6 +1491,7 @@ switch ((IR >> 7) & 037) {                              /* decode IR<0:4> */
         LAC = LAC & 010000 | temp;
 */
 
+    opr_g3:
         temp = MQ;                                      /* group 3 */
         if (IR & 0200)                                  /* CLA */
             LAC = LAC & 010000;
@@ -1293,11 +1573,11 @@ switch ((IR >> 7) & 037) {                              /* decode IR<0:4> */
             if (emode) {
                 MA = IF | PC;
                 if ((MA & 07770) != 00010)              /* indirect; autoinc? */
-                    MA = DF | M[MA];
-                else MA = DF | (M[MA] = (M[MA] + 1) & 07777); /* incr before use */
-                MQ = MQ + M[MA];
+                    MA = DF | MEM_RD (MA);
+                else MA = DF | MEM_WR (MA, (MEM_RD (MA) + 1) & 07777); /* incr before use */
+                MQ = MQ + MEM_RD (MA);
                 MA = DF | ((MA + 1) & 07777);
-                LAC = (LAC & 07777) + M[MA] + (MQ >> 12);
+                LAC = (LAC & 07777) + MEM_RD (MA) + (MQ >> 12);
                 MQ = MQ & 07777;
                 PC = (PC + 1) & 07777;
                 break;
@@ -1318,13 +1598,13 @@ switch ((IR >> 7) & 037) {                              /* decode IR<0:4> */
             if (emode) {
                 MA = IF | PC;
                 if ((MA & 07770) != 00010)              /* indirect; autoinc? */
-                    MA = DF | M[MA];
-                else MA = DF | (M[MA] = (M[MA] + 1) & 07777); /* incr before use */
+                    MA = DF | MEM_RD (MA);
+                else MA = DF | MEM_WR (MA, (MEM_RD (MA) + 1) & 07777); /* incr before use */
                 if (MEM_ADDR_OK (MA))
-                    M[MA] = MQ & 07777;
+                    MEM_WR (MA, MQ & 07777);
                 MA = DF | ((MA + 1) & 07777);
                 if (MEM_ADDR_OK (MA))
-                    M[MA] = LAC & 07777;
+                    MEM_WR (MA, LAC & 07777);
                 PC = (PC + 1) & 07777;
                 break;
                 }
@@ -1333,10 +1613,10 @@ switch ((IR >> 7) & 037) {                              /* decode IR<0:4> */
             MA = IF | PC;
             if (emode) {                                /* mode B: defer */
                 if ((MA & 07770) != 00010)              /* indirect; autoinc? */
-                    MA = DF | M[MA];
-                else MA = DF | (M[MA] = (M[MA] + 1) & 07777); /* incr before use */
+                    MA = DF | MEM_RD (MA);
+                else MA = DF | MEM_WR (MA, (MEM_RD (MA) + 1) & 07777); /* incr before use */
                 }
-            temp = (MQ * M[MA]) + (LAC & 07777);
+            temp = (MQ * MEM_RD (MA)) + (LAC & 07777);
             LAC = (temp >> 12) & 07777;
             MQ = temp & 07777;
             PC = (PC + 1) & 07777;
@@ -1351,18 +1631,18 @@ switch ((IR >> 7) & 037) {                              /* decode IR<0:4> */
             MA = IF | PC;
             if (emode) {                                /* mode B: defer */
                 if ((MA & 07770) != 00010)              /* indirect; autoinc? */
-                    MA = DF | M[MA];
-                else MA = DF | (M[MA] = (M[MA] + 1) & 07777); /* incr before use */
+                    MA = DF | MEM_RD (MA);
+                else MA = DF | MEM_WR (MA, (MEM_RD (MA) + 1) & 07777); /* incr before use */
                 }
-            if ((LAC & 07777) >= M[MA]) {               /* overflow? */
+            if ((LAC & 07777) >= MEM_RD (MA)) {          /* overflow? */
                 LAC = LAC | 010000;                     /* set link */
                 MQ = ((MQ << 1) + 1) & 07777;           /* rotate MQ */
                 SC = 0;                                 /* no shifts */
                 }
             else {
                 temp = ((LAC & 07777) << 12) | MQ;
-                MQ = temp / M[MA];
-                LAC = temp % M[MA];
+                MQ = temp / MEM_RD (MA);
+                LAC = temp % MEM_RD (MA);
                 SC = 015;                               /* 13 shifts */
                 }
             PC = (PC + 1) & 07777;
@@ -1377,9 +1657,8 @@ switch ((IR >> 7) & 037) {                              /* decode IR<0:4> */
             LAC = LAC | SC;                             /* mode A: SCA then */
         case 004:                                       /* NMI */
             temp = (LAC << 12) | MQ;                    /* preserve link */
-            for (SC = 0; ((temp & 017777777) != 0) &&
-                (temp & 040000000) == ((temp << 1) & 040000000); SC++)
-                temp = temp << 1;
+            SC = eae_nmi (temp);                        /* shift in one step */
+            temp = temp << SC;
             LAC = (temp >> 12) & 017777;
             MQ = temp & 07777;
             if (emode && ((LAC & 07777) == 04000) && (MQ == 0))
@@ -1460,6 +1739,7 @@ switch ((IR >> 7) & 037) {                              /* decode IR<0:4> */
    the ECDF flag is set, otherwise it is cleared. */
 
     case 030:case 031:case 032:case 033:                /* IOT */
+    iot:
         if (UF) {                                       /* privileged? */
             int_req = int_req | INT_UF;                 /* request intr */
             tsc_ir = IR;                                /* save instruction */
@@ -1659,7 +1939,7 @@ ledstatus[6] |= 1<<8; // set pause led
             break;
             }                                           /* end switch device */
 /* --------------------------------------------------------------------------------------------------------- */
-ledstatus[6] &= ~(1<<8); // clear pause led
+// pause led is cleared once it has been sampled, in setleds
 
 ledstatus[5] &= ~(1<<0); // clear WC led
 ledstatus[6] &= ~(1<<11); // clear CA led
@@ -1668,6 +1948,11 @@ ledstatus[6] &= ~(1<<10); // clear Break led
         break;                                          /* end case IOT */
         }                                               /* end switch opcode */
 
+#if defined (CPU_THREADED)
+    if (sb_left != 0)                                   /* in superblock? */
+        goto sb_step;
+#endif
+
 /* ------------------------------------------------------------------------- */
 skip:	;	// goto label
 /* ------------------------------------------------------------------------- */
@@ -1681,6 +1966,12 @@ saved_DF = DF & 070000;
 saved_LAC = LAC & 017777;
 saved_MQ = MQ & 07777;
 pcq_r->qptr = pcq_p;                                    /* update pc q ptr */
+if (hst_map)                                            /* ring file? */
+    hst_map->p = hst_p;                                 /* save its pointer */
+if (shm_map)                                            /* exporting? */
+    shm_put (saved_PC, saved_DF, saved_LAC, saved_MQ, 0);
+if (rr_mode)                                            /* recording, replaying? */
+    rr_stop ();
 return reason;
 }                                                       /* end sim_instr */
 
@@ -1695,7 +1986,9 @@ pcq_r = find_reg ("PCQ", NULL, dptr);
 if (pcq_r)
     pcq_r->qptr = 0;
 else return SCPE_IERR;
-sim_brk_types = sim_brk_dflt = SWMASK ('E');
+sim_brk_types = SWMASK ('E') | SWMASK ('R') | SWMASK ('W');
+sim_brk_dflt = SWMASK ('E');
+opr_build ();                                           /* decode OPR table */
 return SCPE_OK;
 }
 
@@ -1724,7 +2017,7 @@ t_stat cpu_dep (t_value val, t_addr addr, UNIT *uptr, int32 sw)
 {
 if (addr >= MEMSIZE)
     return SCPE_NXM;
-M[addr] = val & 07777;
+MEM_PUT (addr, val & 07777);
 return SCPE_OK;
 }
 
@@ -1747,6 +2040,499 @@ for (i = MEMSIZE; i < MAXMEMSIZE; i++)
 return SCPE_OK;
 }
 
+/* Predecode one word of memory */
+
+void pdc_fill (uint32 ma)
+{
+int32 ir = M[ma];
+PDCENT *p = &pdc[ma];
+
+p->ea = ma;                                             /* default: IF'PC */
+p->sbl = 0;                                             /* look for block */
+if (ir < 06000) {                                       /* mem ref? */
+    p->op = ((ir >> 7) & 037) + 1;                      /* decode point + 1 */
+    if (ir < 04000) {                                   /* data reference? */
+        if (ir & 0200)                                  /* curr page */
+            p->ea = (ma & 077600) | (ir & 0177);
+        else p->ea = (ma & 070000) | (ir & 0177);       /* page zero */
+        }
+    }
+else if (ir < 07000)                                    /* IOT */
+    p->op = PDC_IOT;
+else if ((ir & 0400) == 0)                              /* OPR group 1 */
+    p->op = PDC_OPR1;
+else if ((ir & 01) == 0)                                /* OPR group 2 */
+    p->op = PDC_OPR2;
+else p->op = PDC_OPR3;                                  /* OPR group 3 */
+return;
+}
+
+/* Build the decoded operate table
+
+   Group 1: CLA and CLL clear bits of the and mask, CMA and CML set bits of
+   the xor mask.  RAL and RTL rotate left 1 and 2 places, RAR and RTR
+   rotate left 12 and 11 places.
+   Group 2: skp has bit (state) set for each state that skips; SMA tests
+   state bit 2, SZA bit 1, SNL bit 0, and IR<8> reverses the sense. */
+
+void opr_build (void)
+{
+static const uint8 rot_map[8] = {
+    0, OPR_BSW, 1, 2, 12, 11, OPR_RALR, OPR_RTLR
+    };
+int32 ir, st, sns, cond;
+OPRDEC *p;
+
+for (ir = 0; ir < 01000; ir++) {
+    p = &opr_dec[ir];
+    p->andm = 017777;
+    p->xorm = 0;
+    p->iac = p->rot = p->skp = p->flg = 0;
+    if (ir & 0200)                                      /* CLA */
+        p->andm = p->andm & 010000;
+    if ((ir & 0400) == 0) {                             /* group 1 */
+        if (ir & 0100)                                  /* CLL */
+            p->andm = p->andm & 07777;
+        if (ir & 0040)                                  /* CMA */
+            p->xorm = p->xorm | 07777;
+        if (ir & 0020)                                  /* CML */
+            p->xorm = p->xorm | 010000;
+        p->iac = ir & 01;                               /* IAC */
+        p->rot = rot_map[(ir >> 1) & 07];               /* rotates */
+        }
+    else {                                              /* group 2 */
+        sns = (ir >> 3) & OPR_M_SNS;                    /* SMA'SZA'SNL'rev */
+        for (st = 0; st < 8; st++) {                    /* AC<0>'AC=0'L */
+            cond = ((sns & 010) && (st & 04)) ||
+                ((sns & 04) && (st & 02)) ||
+                ((sns & 02) && (st & 01));
+            if (cond ^ (sns & 01))
+                p->skp = p->skp | (1 << st);
+            }
+        p->flg = sns |
+            ((ir & 04)? OPR_OSR: 0) |                   /* OSR */
+            ((ir & 02)? OPR_HLT: 0);                    /* HLT */
+        }
+    }
+return;
+}
+
+/* Data break write notification.  Devices that write memory directly call
+   this so that predecoded instructions in the written range are discarded,
+   and write watchpoints in the range are taken. */
+
+void cpu_dma_wr (uint32 pa, uint32 cnt)
+{
+t_bool watch = (sim_brk_summ & SWMASK ('W')) != 0;
+
+for ( ; cnt != 0; cnt--, pa++) {
+    if (pa < MAXMEMSIZE) {
+        if (pdc[pa].blk)                                /* in superblock? */
+            sb_inval (pa);
+        pdc[pa].op = PDC_MISS;
+        if (watch)
+            cpu_watch (pa, SWMASK ('W'));
+        }
+    }
+return;
+}
+
+/* EAE normalize shift count, bit by bit */
+
+int32 eae_nmi_ref (int32 lm)
+{
+int32 sc;
+
+for (sc = 0; ((lm & 017777777) != 0) &&
+    (lm & 040000000) == ((lm << 1) & 040000000); sc++)
+    lm = lm << 1;
+return sc;
+}
+
+/* Cross-check the EAE kernels against their references
+
+   EAECHECK
+
+   tries NMI on every value of L'AC'MQ, and prints the first mismatches. */
+
+t_stat cpu_eaecheck_cmd (int32 flag, char *cptr)
+{
+int32 lm, sc, ref;
+uint32 bad = 0;
+
+if (*cptr != 0)
+    return SCPE_2MARG;
+for (lm = 0; lm < 0200000000; lm++) {
+    sc = eae_nmi (lm);
+    ref = eae_nmi_ref (lm);
+    if ((sc != ref) && (bad++ < 10))
+        sim_printf ("NMI %o'%04o'%04o: shift %d, reference %d\n",
+            (lm >> 24) & 1, (lm >> 12) & 07777, lm & 07777, sc, ref);
+    }
+sim_printf ("NMI: %d values, %d mismatches\n", 0200000000, bad);
+return bad? SCPE_IERR: SCPE_OK;
+}
+
+/* Watchpoint test.  A hit stops the simulator before the next instruction
+   fetch, after the access completes.  Watchpoints have a breakpoint space
+   of their own, with its repeat suppression cleared on every test, since
+   an access is never retried. */
+
+int32 cpu_watch (uint32 pa, uint32 typ)
+{
+sim_brk_clrspc (WATCH_SPC >> SIM_BKPT_V_SPC);
+if (sim_brk_test (pa, typ | WATCH_SPC))
+    watch_hit = watch_hit | typ;
+return 0;
+}
+
+/* Test whether a predecoded word can appear inside a superblock */
+
+static t_bool sb_inside (uint32 pa)
+{
+switch (pdc[pa].op) {
+
+    case 001: case 002: case 003: case 004:             /* AND */
+    case 005: case 006: case 007: case 010:             /* TAD */
+    case 015: case 016: case 017: case 020:             /* DCA */
+    case PDC_OPR1:
+        return TRUE;
+
+    case PDC_OPR3:                                      /* no EAE function */
+        return ((M[pa] & 0056) == 0);
+        }
+
+return FALSE;
+}
+
+/* Build the superblock starting at ma.  A length of one means that no
+   useful block starts here. */
+
+void sb_build (uint32 ma)
+{
+uint32 i, pa;
+uint32 fld = ma & 070000;
+
+for (i = 0; i < SB_MAX; ) {
+    pa = fld | ((ma + i) & 07777);                      /* PC wraps in field */
+    if (pdc[pa].op == PDC_MISS)
+        pdc_fill (pa);
+    i = i + 1;
+    if (!sb_inside (pa))                                /* end of block? */
+        break;
+    }
+if (i > 1) {
+    for (pa = 0; pa < i; pa++)                          /* flag contents */
+        pdc[fld | ((ma + pa) & 07777)].blk = 1;
+    }
+pdc[ma].sbl = (i > 1)? i: 1;
+return;
+}
+
+/* Discard the superblocks covering a word that is about to be written */
+
+int32 sb_inval (uint32 pa)
+{
+uint32 i, sa;
+uint32 fld = pa & 070000;
+
+for (i = 0; i < SB_MAX; i++) {
+    sa = fld | ((pa - i) & 07777);
+    if (pdc[sa].sbl > i)                                /* covers pa? */
+        pdc[sa].sbl = 0;
+    }
+pdc[pa].blk = 0;
+return 0;
+}
+
+/* Dispatch mode change */
+
+t_stat cpu_set_thrd (UNIT *uptr, int32 val, char *cptr, void *desc)
+{
+#if defined (CPU_THREADED)
+return SCPE_OK;
+#else
+return SCPE_NOFNC;                                      /* no labels as values */
+#endif
+}
+
+/* Execution statistics.  Counting costs one test per instruction when
+   disabled.  OPRs are counted by full microcode, and folded into classes
+   by micro-operation when shown. */
+
+void cpu_count (int32 IR)
+{
+cst_op[(IR >> 7) & 037]++;                              /* decode point */
+if (IR >= 07000)                                        /* OPR? */
+    cst_opr[IR & 0777]++;
+else if (IR >= 06000)                                   /* IOT? */
+    cst_iot[(IR >> 3) & 077]++;
+return;
+}
+
+t_stat cpu_set_stats (UNIT *uptr, int32 val, char *cptr, void *desc)
+{
+int32 i;
+
+if (cptr) {
+    if (strcmp (cptr, "RESET") != 0)
+        return SCPE_ARG;
+    memset (cst_op, 0, sizeof (cst_op));                /* clear counts */
+    memset (cst_iot, 0, sizeof (cst_iot));
+    memset (cst_opr, 0, sizeof (cst_opr));
+    cst_int = cst_idle = 0;
+    for (i = 0; i < IDLE_MAXSIG; i++)
+        idle_sig[i].hits = 0;
+    return SCPE_OK;
+    }
+cpu_unit.flags = cpu_unit.flags | UNIT_STATS;
+return SCPE_OK;
+}
+
+t_stat cpu_clr_stats (UNIT *uptr, int32 val, char *cptr, void *desc)
+{
+if (cptr)
+    return SCPE_ARG;
+cpu_unit.flags = cpu_unit.flags & ~UNIT_STATS;
+return SCPE_OK;
+}
+
+t_stat cpu_show_stats (FILE *st, UNIT *uptr, int32 val, void *desc)
+{
+static const char *op_name[] = {
+    "AND", "TAD", "ISZ", "DCA", "JMS", "JMP"
+    };
+static const struct {
+    int32 mask, match;
+    const char *name;
+    } opr_grp[] = {
+    { 0400, 0000, "group 1" },
+    { 0401, 0400, "group 2" },
+    { 0401, 0401, "group 3" }
+    };
+static const struct {
+    int32 grp;                                          /* group */
+    int32 bits, val;                                    /* micro-op */
+    const char *name;
+    } opr_cls[] = {
+    { 0, 0200, 0200, "CLA" },
+    { 0, 0100, 0100, "CLL" },
+    { 0, 0040, 0040, "CMA" },
+    { 0, 0020, 0020, "CML" },
+    { 0, 0016, 0010, "RAR" },
+    { 0, 0016, 0004, "RAL" },
+    { 0, 0016, 0012, "RTR" },
+    { 0, 0016, 0006, "RTL" },
+    { 0, 0016, 0002, "BSW" },
+    { 0, 0001, 0001, "IAC" },
+    { 1, 0110, 0100, "SMA" },
+    { 1, 0050, 0040, "SZA" },
+    { 1, 0030, 0020, "SNL" },
+    { 1, 0110, 0110, "SPA" },
+    { 1, 0050, 0050, "SNA" },
+    { 1, 0030, 0030, "SZL" },
+    { 1, 0170, 0010, "SKP" },
+    { 1, 0200, 0200, "CLA" },
+    { 1, 0004, 0004, "OSR" },
+    { 1, 0002, 0002, "HLT" },
+    { 2, 0200, 0200, "CLA" },
+    { 2, 0100, 0100, "MQA" },
+    { 2, 0040, 0040, "SCA" },
+    { 2, 0020, 0020, "MQL" },
+    { 2, 0016, 0000, "EAE" }                            /* any EAE code */
+    };
+t_uint64 tot, g, c;
+int32 i, j, k;
+
+for (i = 0, tot = 0; i < 32; i++)
+    tot = tot + cst_op[i];
+fprintf (st, "Instructions: %" LL_FMT "u%s\n", tot,
+    (cpu_unit.flags & UNIT_STATS)? "": " (statistics disabled)");
+fprintf (st, "Interrupts:   %" LL_FMT "u\n", cst_int);
+fprintf (st, "Idle calls:   %" LL_FMT "u\n", cst_idle);
+fprintf (st, "\n    %13s %13s %13s %13s\n", "dir zero", "dir curr", "ind zero", "ind curr");
+for (i = 0; i < 6; i++) {                               /* memory reference */
+    fprintf (st, "%s", op_name[i]);
+    for (j = 0; j < 4; j++)
+        fprintf (st, " %13" LL_FMT "u", cst_op[(i << 2) | j]);
+    fputc ('\n', st);
+    }
+fprintf (st, "IOT %13" LL_FMT "u\n", cst_op[030] + cst_op[031] + cst_op[032] + cst_op[033]);
+for (i = 0; i < DEV_MAX; i++) {                         /* IOTs by device */
+    if (cst_iot[i])
+        fprintf (st, "  device %02o %13" LL_FMT "u\n", i, cst_iot[i]);
+    }
+for (k = 0; k < 3; k++) {                               /* OPRs by group */
+    for (i = 0, g = 0; i < 01000; i++) {
+        if ((i & opr_grp[k].mask) == opr_grp[k].match)
+            g = g + cst_opr[i];
+        }
+    fprintf (st, "OPR %s %13" LL_FMT "u\n", opr_grp[k].name, g);
+    for (j = 0; g && (j < (int32) (sizeof (opr_cls) / sizeof (opr_cls[0]))); j++) {
+        if (opr_cls[j].grp != k)
+            continue;
+        for (i = 0, c = 0; i < 01000; i++) {            /* sum microcodes */
+            if (((i & opr_grp[k].mask) == opr_grp[k].match) &&
+                ((opr_cls[j].val == 0)?                 /* any bit, or match */
+                ((i & opr_cls[j].bits) != 0): ((i & opr_cls[j].bits) == opr_cls[j].val)))
+                c = c + cst_opr[i];
+            }
+        if (c)
+            fprintf (st, "  %-9s %13" LL_FMT "u\n", opr_cls[j].name, c);
+        }
+    }
+return SCPE_OK;
+}
+
+/* Pace execution.  q units of machine time have been executed since the
+   last call; wait until as much host time has passed since rt_base.  If
+   the host has fallen far behind, from a stop or a slow host, start again
+   from now rather than run flat out to catch up.  q < 0 starts pacing. */
+
+void rt_pace (int32 q)
+{
+struct timespec now, tgt;
+t_int64 d;
+
+clock_gettime (CLOCK_MONOTONIC, &now);
+if (q >= 0) {
+    rt_ns = rt_ns + (t_uint64) q * RT_UNIT;
+    d = ((t_int64) (now.tv_sec - rt_base.tv_sec) * 1000000000) +
+        (now.tv_nsec - rt_base.tv_nsec) - (t_int64) rt_ns; /* host ahead */
+    if (d < 0) {                                        /* machine ahead? */
+        tgt.tv_sec = rt_base.tv_sec + (time_t) (rt_ns / 1000000000);
+        tgt.tv_nsec = rt_base.tv_nsec + (long) (rt_ns % 1000000000);
+        if (tgt.tv_nsec >= 1000000000) {
+            tgt.tv_sec++;
+            tgt.tv_nsec = tgt.tv_nsec - 1000000000;
+            }
+        while (clock_nanosleep (CLOCK_MONOTONIC, TIMER_ABSTIME, &tgt, NULL) == EINTR)
+            continue;
+        return;
+        }
+    if (d < RT_SLIP)                                    /* close enough? */
+        return;
+    }
+rt_base = now;                                          /* (re)start */
+rt_ns = 0;
+return;
+}
+
+/* Idle loop signature match, for a loop of lnt words at pa closed by a JMP */
+
+t_bool idle_match (uint32 pa, int32 lnt)
+{
+IDLESIG *sp;
+int32 i;
+
+for (sp = idle_sig; sp < idle_sig + IDLE_MAXSIG; sp++) {
+    if ((sp->name[0] == 0) || (sp->lnt != lnt) ||       /* unused, wrong size, */
+        ((int_req & sp->need) != sp->need) ||           /* or wrong intr state? */
+        (int_req & sp->clr))
+        continue;
+    for (i = 0; i < lnt; i++) {                         /* compare loop */
+        if ((M[pa + i] & sp->mask[i]) != sp->val[i])
+            break;
+        }
+    if (i >= lnt) {                                     /* match? */
+        sp->hits++;
+        return TRUE;
+        }
+    }
+return FALSE;
+}
+
+/* Add or replace an idle signature, IDLESIG=name;ION|IOF{;val{/mask}...}
+
+   The words are those ahead of the closing JMP.  An ION loop may idle
+   when no interrupt is pending; an IOF loop only when no device flag is
+   up at all. */
+
+t_stat cpu_set_isig (UNIT *uptr, int32 val, char *cptr, void *desc)
+{
+IDLESIG sig, *sp, *fp;
+char gbuf[CBUFSIZE];
+const char *tptr;
+
+if (cptr == NULL)
+    return SCPE_MISVAL;
+memset (&sig, 0, sizeof (sig));
+cptr = get_glyph (cptr, gbuf, ';');                     /* name */
+if ((gbuf[0] == 0) || (strlen (gbuf) >= sizeof (sig.name)))
+    return SCPE_ARG;
+strcpy (sig.name, gbuf);
+cptr = get_glyph (cptr, gbuf, ';');                     /* intr state */
+if (strcmp (gbuf, "ION") == 0) {
+    sig.need = INT_ION;
+    sig.clr = INT_ALL;
+    }
+else if (strcmp (gbuf, "IOF") == 0)
+    sig.clr = INT_ION | INT_ALL;
+else return SCPE_ARG;
+while (*cptr) {                                         /* loop words */
+    cptr = get_glyph (cptr, gbuf, ';');
+    if (sig.lnt >= IDLE_MAXW)
+        return SCPE_ARG;
+    sig.val[sig.lnt] = (uint16) strtotv (gbuf, &tptr, 8);
+    if (*tptr == '/')
+        sig.mask[sig.lnt] = (uint16) strtotv (tptr + 1, &tptr, 8);
+    else sig.mask[sig.lnt] = 07777;
+    if ((*tptr != 0) || (sig.val[sig.lnt] & ~sig.mask[sig.lnt] & 07777) ||
+        (sig.mask[sig.lnt] > 07777))
+        return SCPE_ARG;
+    sig.lnt++;
+    }
+for (sp = idle_sig, fp = NULL; sp < idle_sig + IDLE_MAXSIG; sp++) {
+    if (strcmp (sp->name, sig.name) == 0)               /* replace? */
+        break;
+    if ((fp == NULL) && (sp->name[0] == 0))             /* first free */
+        fp = sp;
+    }
+if (sp >= idle_sig + IDLE_MAXSIG) {                     /* new? */
+    if (fp == NULL)
+        return SCPE_MEM;
+    sp = fp;
+    }
+*sp = sig;
+return SCPE_OK;
+}
+
+t_stat cpu_clr_isig (UNIT *uptr, int32 val, char *cptr, void *desc)
+{
+IDLESIG *sp;
+
+if (cptr == NULL)
+    return SCPE_MISVAL;
+for (sp = idle_sig; sp < idle_sig + IDLE_MAXSIG; sp++) {
+    if ((sp->name[0] != 0) && (strcmp (sp->name, cptr) == 0)) {
+        memset (sp, 0, sizeof (*sp));
+        return SCPE_OK;
+        }
+    }
+return SCPE_ARG;
+}
+
+t_stat cpu_show_isig (FILE *st, UNIT *uptr, int32 val, void *desc)
+{
+IDLESIG *sp;
+int32 i;
+
+fprintf (st, "Idle signatures:\n");
+for (sp = idle_sig; sp < idle_sig + IDLE_MAXSIG; sp++) {
+    if (sp->name[0] == 0)
+        continue;
+    fprintf (st, "  %-15s %s  %13" LL_FMT "u ", sp->name,
+        (sp->need & INT_ION)? "ION": "IOF", sp->hits);
+    for (i = 0; i < sp->lnt; i++) {
+        if (sp->mask[i] == 07777)
+            fprintf (st, " %04o", sp->val[i]);
+        else fprintf (st, " %04o/%04o", sp->val[i], sp->mask[i]);
+        }
+    fprintf (st, " JMP\n");
+    }
+return SCPE_OK;
+}
+
 /* Change device number for a device */
 
 t_stat set_dev (UNIT *uptr, int32 val, char *cptr, void *desc)
@@ -1853,12 +2639,7 @@ if (cptr == NULL) {
 lnt = (int32) get_uint (cptr, 10, HIST_MAX, &r);
 if ((r != SCPE_OK) || (lnt && (lnt < HIST_MIN)))
     return SCPE_ARG;
-hst_p = 0;
-if (hst_lnt) {
-    free (hst);
-    hst_lnt = 0;
-    hst = NULL;
-    }
+hst_free ();
 if (lnt) {
     hst = (InstHistory *) calloc (lnt, sizeof (InstHistory));
     if (hst == NULL)
@@ -1872,13 +2653,10 @@ return SCPE_OK;
 
 t_stat cpu_show_hist (FILE *st, UNIT *uptr, int32 val, void *desc)
 {
-int32 l, k, di, lnt;
+int32 k, di, lnt;
 char *cptr = (char *) desc;
 t_stat r;
-t_value sim_eval;
 InstHistory *h;
-extern t_stat fprint_sym (FILE *ofile, t_addr addr, t_value *val,
-    UNIT *uptr, int32 sw);
 
 if (hst_lnt == 0)                                       /* enabled? */
     return SCPE_NOFNC;
@@ -1894,29 +2672,348 @@ if (di < 0)
 fprintf (st, "PC     L AC    MQ    ea     IR\n\n");
 for (k = 0; k < lnt; k++) {                             /* print specified */
     h = &hst[(++di) % hst_lnt];                         /* entry pointer */
-    if (h->pc & HIST_PC) {                              /* instruction? */
-        l = (h->lac >> 12) & 1;                         /* link */
-        fprintf (st, "%05o  %o %04o  %04o  ", h->pc & ADDRMASK, l, h->lac & 07777, h->mq);
-        if (h->ir < 06000)
-            fprintf (st, "%05o  ", h->ea);
-        else fprintf (st, "       ");
-        sim_eval = h->ir;
-        if ((fprint_sym (st, h->pc & ADDRMASK, &sim_eval, &cpu_unit, SWMASK ('M'))) > 0)
-            fprintf (st, "(undefined) %04o", h->ir);
-        if (h->ir < 04000)
-            fprintf (st, "  [%04o]", h->opnd);
-        fputc ('\n', st);                               /* end line */
-        }                                               /* end else instruction */
+    if (h->pc & HIST_PC)                                /* instruction? */
+        hst_fprint (st, h);
     }                                                   /* end for */
 return SCPE_OK;
 }
 
+/* Print one history entry */
+
+void hst_fprint (FILE *st, InstHistory *h)
+{
+int32 l;
+t_value sim_eval;
+extern t_stat fprint_sym (FILE *ofile, t_addr addr, t_value *val,
+    UNIT *uptr, int32 sw);
+
+l = (h->lac >> 12) & 1;                                 /* link */
+fprintf (st, "%05o  %o %04o  %04o  ", h->pc & ADDRMASK, l, h->lac & 07777, h->mq);
+if (h->ir < 06000)
+    fprintf (st, "%05o  ", h->ea);
+else fprintf (st, "       ");
+sim_eval = h->ir;
+if ((fprint_sym (st, h->pc & ADDRMASK, &sim_eval, &cpu_unit, SWMASK ('M'))) > 0)
+    fprintf (st, "(undefined) %04o", h->ir);
+if (h->ir < 04000)
+    fprintf (st, "  [%04o]", h->opnd);
+fputc ('\n', st);                                       /* end line */
+return;
+}
+
+/* Release the history, in memory or mapped */
+
+void hst_free (void)
+{
+if (hst_map)
+    munmap (hst_map, sizeof (HistFile) + hst_lnt * sizeof (InstHistory));
+else free (hst);
+hst_map = NULL;
+hst = NULL;
+hst_lnt = hst_p = 0;
+return;
+}
+
+/* Set history ring file, HFILE=n;file */
+
+t_stat cpu_set_hfile (UNIT *uptr, int32 val, char *cptr, void *desc)
+{
+int32 fd, lnt;
+char *fname;
+size_t sz;
+void *base;
+t_stat r;
+
+if (cptr == NULL)
+    return SCPE_MISVAL;
+fname = strchr (cptr, ';');
+if (fname) {
+    *fname++ = 0;
+    lnt = (int32) get_uint (cptr, 10, HFILE_MAX, &r);
+    if ((r != SCPE_OK) || (lnt < HIST_MIN))
+        return SCPE_ARG;
+    }
+else {
+    fname = cptr;
+    lnt = HFILE_DFLT;
+    }
+if (*fname == 0)
+    return SCPE_ARG;
+sz = sizeof (HistFile) + (size_t) lnt * sizeof (InstHistory);
+fd = open (fname, O_RDWR | O_CREAT | O_TRUNC, 0644);
+if (fd < 0)
+    return SCPE_OPENERR;
+if (ftruncate (fd, sz)) {                               /* zero filled */
+    close (fd);
+    return SCPE_IOERR;
+    }
+base = mmap (NULL, sz, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+close (fd);                                             /* map stays */
+if (base == MAP_FAILED)
+    return SCPE_MEM;
+hst_free ();
+hst_map = (HistFile *) base;
+memcpy (hst_map->magic, HFILE_MAGIC, sizeof (hst_map->magic));
+hst_map->rsize = sizeof (InstHistory);
+hst_map->lnt = lnt;
+hst = (InstHistory *) (hst_map + 1);
+hst_lnt = lnt;
+strncpy (hst_fname, fname, sizeof (hst_fname) - 1);
+return SCPE_OK;
+}
+
+t_stat cpu_clr_hfile (UNIT *uptr, int32 val, char *cptr, void *desc)
+{
+if (cptr)
+    return SCPE_ARG;
+if (hst_map) {
+    hst_map->p = hst_p;
+    hst_free ();
+    }
+return SCPE_OK;
+}
+
+t_stat cpu_show_hfile (FILE *st, UNIT *uptr, int32 val, void *desc)
+{
+if (hst_map)
+    fprintf (st, "history file=%s, %d entries\n", hst_fname, hst_lnt);
+else fprintf (st, "no history file\n");
+return SCPE_OK;
+}
+
+/* Publish the registers to the shared segment */
+
+void shm_put (int32 pc, int32 df, int32 lac, int32 mq, int32 run)
+{
+uint32 *r = shm_map->shm_reg[SHM_BUF (shm_map->shm_seq + 2)];
+
+__atomic_thread_fence (__ATOMIC_RELEASE);               /* last publish first */
+r[SHM_PC] = pc;
+r[SHM_DF] = df;
+r[SHM_LAC] = lac;
+r[SHM_MQ] = mq;
+r[SHM_INTREQ] = int_req;
+r[SHM_RUN] = run;
+shm_map->shm_msize = (uint32) MEMSIZE;
+__atomic_store_n (&shm_map->shm_seq, shm_map->shm_seq + 2, __ATOMIC_RELEASE);
+return;
+}
+
+/* Move main memory to to, with its contents and the registers in it */
+
+void mem_move (uint16 *to)
+{
+DEVICE *dptr;
+REG *rptr;
+uint32 i;
+char *lo = (char *) M, *hi = (char *) M + MEM_BYTES;
+
+if (to == M)
+    return;
+memcpy (to, M, MEM_BYTES);
+for (i = 0; (dptr = sim_devices[i]) != NULL; i++) {
+    for (rptr = dptr->registers; (rptr != NULL) && (rptr->name != NULL); rptr++) {
+        if (((char *) rptr->loc >= lo) && ((char *) rptr->loc < hi))
+            rptr->loc = (char *) to + ((char *) rptr->loc - lo);
+        }
+    }
+M = to;
+return;
+}
+
+/* Set shared memory export, SHM=name
+
+   Creates the POSIX shared memory object /name, described by pdp8_shm.h,
+   and moves main memory into it.  The object is removed by NOSHM, which
+   moves memory back to mem_home.  M is switched only once the segment is
+   mapped, so a failure leaves memory where it was. */
+
+t_stat cpu_set_shm (UNIT *uptr, int32 val, char *cptr, void *desc)
+{
+int32 fd;
+void *base;
+char name[CBUFSIZE + 1];
+
+if ((cptr == NULL) || (*cptr == 0))
+    return SCPE_MISVAL;
+if ((strchr (cptr, '/') != NULL) || (strlen (cptr) >= sizeof (shm_name)))
+    return SCPE_ARG;
+if (shm_map)                                            /* one at a time */
+    cpu_clr_shm (uptr, 0, NULL, desc);
+sprintf (name, "/%s", cptr);
+fd = shm_open (name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+if (fd < 0)
+    return SCPE_OPENERR;
+if (ftruncate (fd, SHM_MEMOFF + MEM_BYTES)) {
+    close (fd);
+    shm_unlink (name);
+    return SCPE_IOERR;
+    }
+base = mmap (NULL, SHM_MEMOFF + MEM_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+close (fd);                                             /* map stays */
+if (base == MAP_FAILED) {
+    shm_unlink (name);
+    return SCPE_MEM;
+    }
+shm_map = (SHM_HDR *) base;
+mem_move ((uint16 *) ((char *) base + SHM_MEMOFF));     /* move memory in */
+shm_map->shm_version = SHM_VERSION;
+shm_map->shm_mem = MAXMEMSIZE;
+memcpy (shm_map->shm_magic, SHM_MAGIC, sizeof (shm_map->shm_magic));
+strcpy (shm_name, cptr);
+shm_put (saved_PC, saved_DF, saved_LAC, saved_MQ, 0);
+return SCPE_OK;
+}
+
+t_stat cpu_clr_shm (UNIT *uptr, int32 val, char *cptr, void *desc)
+{
+char name[CBUFSIZE + 1];
+
+if (cptr)
+    return SCPE_ARG;
+if (shm_map == NULL)
+    return SCPE_OK;
+mem_move (mem_home);                                    /* memory back home */
+munmap (shm_map, SHM_MEMOFF + MEM_BYTES);
+shm_map = NULL;
+sprintf (name, "/%s", shm_name);
+shm_unlink (name);
+return SCPE_OK;
+}
+
+t_stat cpu_show_shm (FILE *st, UNIT *uptr, int32 val, void *desc)
+{
+if (shm_map)
+    fprintf (st, "shared memory=/%s\n", shm_name);
+else fprintf (st, "no shared memory\n");
+return SCPE_OK;
+}
+
+/* Decode a history ring file
+
+   HDUMP file {n} {PC=lo{-hi}} {IR=val{/mask}}
+
+   prints the last n entries (default all) of a ring written by SET CPU
+   HFILE, oldest first, selecting those whose PC is in range and whose
+   instruction matches under the mask.  The file is read, not mapped, so
+   it can be decoded while another simulator is recording into it. */
+
+t_stat cpu_hdump_cmd (int32 flag, char *cptr)
+{
+char fname[CBUFSIZE], gbuf[CBUFSIZE];
+const char *tptr;
+FILE *fp;
+HistFile hdr;
+InstHistory h;
+uint32 n, k, di, pclo = 0, pchi = ADDRMASK, irval = 0, irmask = 0;
+t_stat r;
+
+cptr = get_glyph_nc (cptr, fname, 0);
+if (fname[0] == 0)
+    return SCPE_2FARG;
+n = 0;
+while (*cptr) {
+    cptr = get_glyph (cptr, gbuf, 0);
+    if (strncmp (gbuf, "PC=", 3) == 0) {
+        pclo = (uint32) strtotv (gbuf + 3, &tptr, 8);
+        if (*tptr == '-')
+            pchi = (uint32) strtotv (tptr + 1, &tptr, 8);
+        else pchi = pclo;
+        if ((*tptr != 0) || (pclo > pchi))
+            return SCPE_ARG;
+        }
+    else if (strncmp (gbuf, "IR=", 3) == 0) {
+        irval = (uint32) strtotv (gbuf + 3, &tptr, 8);
+        if (*tptr == '/')
+            irmask = (uint32) strtotv (tptr + 1, &tptr, 8);
+        else irmask = 07777;
+        if (*tptr != 0)
+            return SCPE_ARG;
+        }
+    else {
+        n = (uint32) get_uint (gbuf, 10, HFILE_MAX, &r);
+        if ((r != SCPE_OK) || (n == 0))
+            return SCPE_ARG;
+        }
+    }
+fp = sim_fopen (fname, "rb");
+if (fp == NULL)
+    return SCPE_OPENERR;
+if ((fread (&hdr, sizeof (hdr), 1, fp) != 1) ||
+    memcmp (hdr.magic, HFILE_MAGIC, sizeof (hdr.magic)) ||
+    (hdr.rsize != sizeof (InstHistory)) ||
+    (hdr.lnt == 0) || (hdr.p >= hdr.lnt)) {
+    fclose (fp);
+    return SCPE_FMT;
+    }
+if ((n == 0) || (n > hdr.lnt))
+    n = hdr.lnt;
+di = (hdr.p + hdr.lnt - n + 1) % hdr.lnt;               /* oldest wanted */
+sim_fseek (fp, sizeof (hdr) + di * sizeof (InstHistory), SEEK_SET);
+sim_printf ("PC     L AC    MQ    ea     IR\n\n");
+for (k = 0; k < n; k++, di++) {
+    if (di == hdr.lnt) {                                /* wrap */
+        di = 0;
+        sim_fseek (fp, sizeof (hdr), SEEK_SET);
+        }
+    if (fread (&h, sizeof (h), 1, fp) != 1)
+        break;
+    if (((h.pc & HIST_PC) == 0) ||                      /* unused? */
+        ((uint32) (h.pc & ADDRMASK) < pclo) || ((uint32) (h.pc & ADDRMASK) > pchi) ||
+        ((h.ir & irmask) != irval))
+        continue;
+    hst_fprint (stdout, &h);
+    if (sim_log)
+        hst_fprint (sim_log, &h);
+    }
+fclose (fp);
+return SCPE_OK;
+}
+
 
 
 /* ------------------------------------------------------------------------------------ */
+// GLOW mode: add a panel frame to the on-counts. The counts are bit-sliced, so all 96 LEDs
+// are counted at once, as two 48 bit words, with a ripple carry through the count bit
+// planes; the carry almost always dies out after a plane or two.
+// The counts are accumulated directly in the unpublished glowpub buffer.
+
+void ledacc_add(uint32 *f)
+{
+	uint64_t c0, c1, t;
+	int p;
+
+	if (ledacc->samples >= (1u << LED_PLANES) - 1)	// frame full: counts would overflow
+		return;
+	ledacc->samples++;
+	c0 = (uint64_t) (f[0] & 07777) | ((uint64_t) (f[1] & 07777) << 12) |
+		((uint64_t) (f[2] & 07777) << 24) | ((uint64_t) (f[3] & 07777) << 36);
+	c1 = (uint64_t) (f[4] & 07777) | ((uint64_t) (f[5] & 07777) << 12) |
+		((uint64_t) (f[6] & 07777) << 24) | ((uint64_t) (f[7] & 07777) << 36);
+	for (p = 0; (c0 | c1) != 0; p++)
+	{	t = ledacc->plane[0][p] & c0;	// add c0, c1 into plane p; carries move up
+		ledacc->plane[0][p] ^= c0;
+		c0 = t;
+		t = ledacc->plane[1][p] & c1;
+		ledacc->plane[1][p] ^= c1;
+		c1 = t;
+	}
+}
+
 uint32 tempLeds=0;
 void setleds(uint32 sPC, uint32 sMA, uint16 sMB, int32 sLAC, int32 sMQ, int32 sIF, int32 sDF)
 {
+	uint16 inst;
+	uint32 *f;
+
+	if (ledreq)			// panel started a new frame:
+	{	ledreq = 0;
+		if (ledglow)		// hand it the counts of the one just finished
+		{	panel_publish(&glowpub.seq);
+			ledacc = panel_next(&glowpub.seq, glowpub.buf, sizeof(glowpub.buf[0]));
+			memset(ledacc, 0, sizeof(*ledacc));
+		}
+	}
 
 	ledstatus[0] = (uint32) sPC;
 	ledstatus[1] = (uint32) sMA;
@@ -1930,7 +3027,9 @@ void setleds(uint32 sPC, uint32 sMA, uint16 sMB, int32 sLAC, int32 sMQ, int32 sI
 //	tempLeds = ledstatus[5] & 12; // preserve value of fetch/execute handled in main loop
 	tempLeds = ledstatus[5] & 13; // preserve value of fetch/execute/WC handled in main loop
 
-	switch((M[sMA] & 0xE00) >> 9)
+	inst = M[sMA];					// read the instruction once
+
+	switch((inst & 0xE00) >> 9)
 	{
 		case 0:	tempLeds+=(1<<11); break;		// 000 AND
 		case 1:	tempLeds+=(1<<10); break;		// 001 TAD
@@ -1943,8 +3042,8 @@ void setleds(uint32 sPC, uint32 sMA, uint16 sMB, int32 sLAC, int32 sMQ, int32 sI
 		default: printf("instruction error in multiplexer");	// debug only, remove
 	}
 
-	if ( ((M[sMA] & 0xE00) >> 9) <= 5)	// <=5: all memory reference instructions
-		if ((M[sMA] & 0x100) != 0)	// if fourth bit is set, this is indirect addressing, so...
+	if ( ((inst & 0xE00) >> 9) <= 5)	// <=5: all memory reference instructions
+		if ((inst & 0x100) != 0)	// if fourth bit is set, this is indirect addressing, so...
 		tempLeds += (1<<1);		// ...light defer
 		
 	ledstatus[5]=tempLeds;
@@ -1967,6 +3066,17 @@ void setleds(uint32 sPC, uint32 sMA, uint16 sMB, int32 sLAC, int32 sMQ, int32 sI
 
 	ledstatus[7]=tempLeds;
 
+	// Publish the frame. Fetch and execute both happen on every instruction, so while
+	// running both are shown; pause stays lit until the sample after the IOT that lit it.
+	f = panel_next(&ledpub.seq, ledpub.buf, sizeof(ledpub.buf[0]));
+	memcpy(f, ledstatus, sizeof(ledstatus));
+	if (swStop == 0)
+		f[5] |= (1<<3) | (1<<2);	// fetch, execute
+	panel_publish(&ledpub.seq);
+	ledstatus[6] &= ~(1<<8);		// clear pause led
+
+	if (ledglow)
+		ledacc_add(f);
 }
 /* ------------------------------------------------------------------------------------ */
 
@@ -1990,7 +3100,11 @@ int mountUSBStickFile(int devNo, char *devCode, char *sPath)
 	// if mounting another image to a device, clear the current file from the mountlist:
 	mountedFiles[devNo][0]=0x00;
 
-	for (i=0;i<8;i++)				// search all 8 USB mount points
+	// replaying a recorded run: mount the file that was mounted then, without searching
+	if ((rr_mode == RR_PLAY) && (rr_mount(devCode) != NULL))
+		strcpy(sFoundFile, rr_mount(devCode));
+
+	for (i=0;(i<8) && (sFoundFile[0]==0);i++)	// search all 8 USB mount points
 	{
 		sprintf(sUSBPath,"/media/usb%d",i);	// usb sticks are numbered 0..7
 //printf("1- %s\r\n", sUSBPath);
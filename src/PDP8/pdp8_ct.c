@@ -719,7 +719,7 @@ static const uint16 boot_rom[] = {
 t_stat ct_boot (int32 unitno, DEVICE *dptr)
 {
 size_t i;
-extern uint16 M[];
+extern uint16 *M;
 
 if ((ct_dib.dev != DEV_CT) || unitno)                   /* only std devno */
      return STOP_NOTSTD;
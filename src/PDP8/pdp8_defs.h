@@ -63,6 +63,8 @@
 #define STOP_NOTSTD     5                               /* non-std devno */
 #define STOP_DTOFF      6                               /* DECtape off reel */
 #define STOP_LOOP       7                               /* infinite loop */
+#define STOP_RBKPT      8                               /* read watchpoint */
+#define STOP_WBKPT      9                               /* write watchpoint */
 
 /* Memory */
 
@@ -207,11 +209,78 @@ typedef struct {
 #define INT_PENDING     (INT_ION+INT_NO_CIF_PENDING+INT_NO_ION_PENDING)
 #define INT_UPDATE      ((int_req & ~INT_DEV_ENABLE) | (dev_done & int_enable))
 
+/* Decoded operate instructions
+
+   Every OPR group 1 and group 2 word (07000-07777 with bit 11 clear in
+   group 2) is reduced to the operations it performs.  The table is built
+   by the CPU and used by both the instruction executor and the symbolic
+   decoder, indexed by IR<3:11>.
+
+   Group 1 is ((L'AC & and) ^ xor) + iac, then a rotate of the 13 bit L'AC
+   left by rot places; rot values above 12 are BSW and the two undefined
+   rotate combinations.  Group 2 skips if bit (state) of skp is set, where
+   state is AC<0>'AC=0'L, then ands L'AC with and (CLA); flg holds the
+   skip sense bits IR<5:8> and the OSR and HLT flags. */
+
+#define OPR_BSW         13                              /* rot: byte swap */
+#define OPR_RALR        14                              /* rot: RAL RAR */
+#define OPR_RTLR        15                              /* rot: RTL RTR */
+#define OPR_M_SNS       017                             /* flg: skip sense */
+#define OPR_OSR         020                             /* flg: OSR */
+#define OPR_HLT         040                             /* flg: HLT */
+
+typedef struct {
+    uint16              andm;                           /* L'AC and mask */
+    uint16              xorm;                           /* L'AC xor mask */
+    uint8               iac;                            /* increment */
+    uint8               rot;                            /* rotate count */
+    uint8               skp;                            /* skip truth table */
+    uint8               flg;                            /* sense, OSR, HLT */
+    } OPRDEC;
+
+/* Run recording and replay (pdp8_rr.c)
+
+   Each nondeterministic input is logged as an event of one of these types;
+   the TTIX types are per line.  RR_INPUT (type, expr) is expr, which is
+   logged if it is nonzero when recording; when replaying, expr is not
+   evaluated and the value logged at this instruction is used, or zero. */
+
+#define RR_OFF          0                               /* rr_mode */
+#define RR_REC          1
+#define RR_PLAY         2
+
+#define RR_END          0                               /* end of recording */
+#define RR_TTI          1                               /* console input */
+#define RR_TTO          2                               /* console output stall */
+#define RR_CAL          3                               /* clock calibration */
+#define RR_IDLE         4                               /* idle, cycles skipped */
+#define RR_SW           5                               /* switch rows */
+#define RR_ATT          6                               /* attach, detach: run */
+#define RR_ATTC         7                               /* attach, detach: sim> */
+#define RR_TTXC         8                               /* TTIX connect change */
+#define RR_TTIX         12                              /* TTIX input */
+#define RR_TTOX         16                              /* TTIX output stall */
+
+#define RR_INPUT(t,x)   ((rr_mode == RR_OFF)? (x): \
+                        rr_input ((t), (rr_mode == RR_REC)? (x): 0))
+
+extern int32 rr_mode;
+extern uint32 rr_conn;
+
+int32 rr_input (int32 type, int32 val);
+int32 rr_calb (int32 ticksper, int32 tmr);
+t_bool rr_idle (uint32 tmr);
+t_stat rr_panel (uint32 *sw);
+void rr_stop (void);
+void rr_attach (UNIT *uptr, char *cptr);
+char *rr_mount (const char *dev);
+
 /* Function prototypes */
 
 t_stat set_dev (UNIT *uptr, int32 val, char *cptr, void *desc);
 t_stat show_dev (FILE *st, UNIT *uptr, int32 val, void *desc);
 
 void cpu_set_bootpc (int32 pc);
+void cpu_dma_wr (uint32 pa, uint32 cnt);
 
 #endif
@@ -96,7 +96,8 @@
 #define UPDATE_PCELL    if (GET_POS (df_time) < 6) df_sta = df_sta | DFS_PCA; \
                         else df_sta = df_sta & ~DFS_PCA
 
-extern uint16 M[];
+extern uint16 *M;
+extern uint16 mem_home[];                               /* for REG tables */
 extern int32 int_req, stop_inst;
 extern UNIT cpu_unit;
 
@@ -137,8 +138,8 @@ UNIT df_unit = {
 REG df_reg[] = {
     { ORDATA (STA, df_sta, 12) },
     { ORDATA (DA, df_da, 12) },
-    { ORDATA (WC, M[DF_WC], 12), REG_FIT },
-    { ORDATA (MA, M[DF_MA], 12), REG_FIT },
+    { ORDATA (WC, mem_home[DF_WC], 12), REG_FIT },
+    { ORDATA (MA, mem_home[DF_MA], 12), REG_FIT },
     { FLDATA (DONE, df_done, 0) },
     { FLDATA (INT, int_req, INT_V_DF) },
     { ORDATA (WLS, df_wlk, 8) },
@@ -269,9 +270,13 @@ do {
         }
     M[DF_WC] = (M[DF_WC] + 1) & 07777;                  /* incr word count */
     M[DF_MA] = (M[DF_MA] + 1) & 07777;                  /* incr mem addr */
+    cpu_dma_wr (DF_WC, 2);
     pa = mex | M[DF_MA];                                /* add extension */
     if (uptr->FUNC == DF_READ) {                        /* read? */
-        if (MEM_ADDR_OK (pa)) M[pa] = fbuf[da];         /* if !nxm, read wd */
+        if (MEM_ADDR_OK (pa)) {                         /* if !nxm, read wd */
+            M[pa] = fbuf[da];
+            cpu_dma_wr (pa, 1);
+            }
         }
     else {                                              /* write */
         t = (da >> 14) & 07;                            /* check wr lock */
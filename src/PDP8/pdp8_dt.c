@@ -264,7 +264,8 @@
                         else int_req = int_req & ~INT_DTA;
 #define ABS(x)          (((x) < 0)? (-(x)): (x))
 
-extern uint16 M[];
+extern uint16 *M;
+extern uint16 mem_home[];                               /* for REG tables */
 extern int32 int_req;
 extern UNIT cpu_unit;
 
@@ -331,8 +332,8 @@ REG dt_reg[] = {
     { FLDATA (ENB, dtsa, DTA_V_ENB) },
     { FLDATA (DTF, dtsb, DTB_V_DTF) },
     { FLDATA (ERF, dtsb, DTB_V_ERF) },
-    { ORDATA (WC, M[DT_WC], 12), REG_FIT },
-    { ORDATA (CA, M[DT_CA], 12), REG_FIT },
+    { ORDATA (WC, mem_home[DT_WC], 12), REG_FIT },
+    { ORDATA (CA, mem_home[DT_CA], 12), REG_FIT },
     { DRDATA (LTIME, dt_ltime, 24), REG_NZ | PV_LEFT },
     { DRDATA (DCTIME, dt_dctime, 24), REG_NZ | PV_LEFT },
     { ORDATA (SUBSTATE, dt_substate, 2) },
@@ -763,9 +764,12 @@ switch (fnc) {                                          /* at speed, check fnc *
             }
         sim_activate (uptr, DTU_LPERB (uptr) * dt_ltime);/* sched next block */
         M[DT_WC] = (M[DT_WC] + 1) & 07777;              /* incr word cnt */
+        cpu_dma_wr (DT_WC, 1);
         ma = DTB_GETMEX (dtsb) | M[DT_CA];              /* get mem addr */
-        if (MEM_ADDR_OK (ma))                           /* store block # */
+        if (MEM_ADDR_OK (ma)) {                         /* store block # */
             M[ma] = blk & 07777;
+            cpu_dma_wr (ma, 1);
+            }
         if (((dtsa & DTA_MODE) == 0) || (M[DT_WC] == 0))
             dtsb = dtsb | DTB_DTF;                      /* set DTF */
         break;
@@ -806,13 +810,16 @@ switch (fnc) {                                          /* at speed, check fnc *
         case 0:                                         /* normal read */
             M[DT_WC] = (M[DT_WC] + 1) & 07777;          /* incr WC, CA */
             M[DT_CA] = (M[DT_CA] + 1) & 07777;
+            cpu_dma_wr (DT_WC, 2);
             ma = DTB_GETMEX (dtsb) | M[DT_CA];          /* get mem addr */
             ba = (blk * DTU_BSIZE (uptr)) + wrd;        /* buffer ptr */
             dat = fbuf[ba];                             /* get tape word */
             if (dir)                                    /* rev? comp obv */
                 dat = dt_comobv (dat);
-            if (MEM_ADDR_OK (ma))                       /* mem addr legal? */
+            if (MEM_ADDR_OK (ma)) {                     /* mem addr legal? */
                 M[ma] = dat;
+                cpu_dma_wr (ma, 1);
+                }
             if (M[DT_WC] == 0)                          /* wc ovf? */
                 dt_substate = DTO_WCO;
         case DTO_WCO:                                   /* wc ovf, not sob */
@@ -865,6 +872,7 @@ switch (fnc) {                                          /* at speed, check fnc *
         case 0:                                         /* normal write */
             M[DT_WC] = (M[DT_WC] + 1) & 07777;          /* incr WC, CA */
             M[DT_CA] = (M[DT_CA] + 1) & 07777;
+            cpu_dma_wr (DT_WC, 2);
         case DTO_WCO:                                   /* wc ovflo */
             ma = DTB_GETMEX (dtsb) | M[DT_CA];          /* get mem addr */
             ba = (blk * DTU_BSIZE (uptr)) + wrd;        /* buffer ptr */
@@ -911,6 +919,7 @@ switch (fnc) {                                          /* at speed, check fnc *
             relpos = DT_LIN2OF (uptr->pos, uptr);       /* cur pos in blk */
             M[DT_WC] = (M[DT_WC] + 1) & 07777;          /* incr WC, CA */
             M[DT_CA] = (M[DT_CA] + 1) & 07777;
+            cpu_dma_wr (DT_WC, 2);
             ma = DTB_GETMEX (dtsb) | M[DT_CA];          /* get mem addr */
             if ((relpos >= DT_HTLIN) &&                 /* in data zone? */
                 (relpos < (DTU_LPERB (uptr) - DT_HTLIN))) {
@@ -922,8 +931,10 @@ switch (fnc) {                                          /* at speed, check fnc *
                 }
             else dat = dt_gethdr (uptr, blk, relpos, dir);      /* get hdr */
             sim_activate (uptr, DT_WSIZE * dt_ltime);
-            if (MEM_ADDR_OK (ma))                       /* mem addr legal? */
+            if (MEM_ADDR_OK (ma)) {                     /* mem addr legal? */
                 M[ma] = dat;
+                cpu_dma_wr (ma, 1);
+                }
             if (M[DT_WC] == 0)
                 dt_substate = DTO_WCO;
             if (((dtsa & DTA_MODE) == 0) || (M[DT_WC] == 0))
@@ -954,6 +965,7 @@ switch (fnc) {                                          /* at speed, check fnc *
             relpos = DT_LIN2OF (uptr->pos, uptr);       /* cur pos in blk */
             M[DT_WC] = (M[DT_WC] + 1) & 07777;          /* incr WC, CA */
             M[DT_CA] = (M[DT_CA] + 1) & 07777;
+            cpu_dma_wr (DT_WC, 2);
             ma = DTB_GETMEX (dtsb) | M[DT_CA];          /* get mem addr */
             if ((relpos >= DT_HTLIN) &&                 /* in data zone? */
                 (relpos < (DTU_LPERB (uptr) - DT_HTLIN))) {
@@ -96,7 +96,7 @@
 #include "pdp8_defs.h"
 
 extern int32 int_req;
-extern uint16 M[];
+extern uint16 *M;
 extern int32 stop_inst;
 extern UNIT cpu_unit;
 
@@ -163,6 +163,7 @@ uint32 fpp_flag = 0;                                    /* flag */
 FPN fpp_ac;                                             /* FAC */
 uint32 fpp_ssf = 0;                                     /* single-step flag */
 uint32 fpp_last_lockbit = 0;                            /* last lockbit */
+uint32 fpp_batch = 1;                                   /* instr per event */
 
 static FPN fpp_zero = { 0, { 0, 0, 0, 0, 0 } };
 static FPN fpp_one = { 1, { 02000, 0, 0, 0, 0 } };
@@ -184,7 +185,9 @@ t_bool fpp_imul (FPN *a, FPN *b);
 uint32 fpp_fr_add (uint32 *c, uint32 *a, uint32 *b, uint32 cnt);
 void fpp_fr_sub (uint32 *c, uint32 *a, uint32 *b, uint32 cnt);
 void fpp_fr_mul (uint32 *c, uint32 *a, uint32 *b, t_bool fix);
+void fpp_fr_mul_ref (uint32 *c, uint32 *a, uint32 *b, t_bool fix);
 t_bool fpp_fr_div (uint32 *c, uint32 *a, uint32 *b);
+t_bool fpp_fr_div_ref (uint32 *c, uint32 *a, uint32 *b);
 uint32 fpp_fr_neg (uint32 *a, uint32 cnt);
 int32 fpp_fr_cmp (uint32 *a, uint32 *b, uint32 cnt);
 int32 fpp_fr_test (uint32 *a, uint32 v0, uint32 cnt);
@@ -195,6 +198,10 @@ void fpp_fr_lsh12 (uint32 *a, uint32 cnt);
 void fpp_fr_lsh1 (uint32 *a, uint32 cnt);
 void fpp_fr_rsh1 (uint32 *a, uint32 sign, uint32 cnt);
 void fpp_fr_algn (uint32 *a, uint32 sc, uint32 cnt);
+void fpp_fr_algn_ref (uint32 *a, uint32 sc, uint32 cnt);
+uint32 fpp_fr_norm (uint32 *a, uint32 cnt);
+uint32 fpp_fr_norm_ref (uint32 *a, uint32 cnt);
+t_stat fpp_check_cmd (int32 flag, char *cptr);
 t_bool fpp_cond_met (uint32 cond);
 t_bool fpp_norm (FPN *a, uint32 cnt);
 void fpp_round (FPN *a);
@@ -239,6 +246,7 @@ REG fpp_reg[] = {
     { ORDATA (SSF, fpp_ssf, 12) },
     { ORDATA (LASTLOCK, fpp_last_lockbit, 12) },
     { FLDATA (FLAG, fpp_flag, 0) },
+    { DRDATA (BATCH, fpp_batch, 12), PV_LEFT },
     { NULL }
     };
 
@@ -343,16 +351,24 @@ switch (IR & 07) {                                      /* decode IR<9:11> */
 return AC;
 }
 
-/* Service routine */
+/* Service routine
+
+   With lockout set, the FPP holds the CPU off, and runs until the next
+   event is due.  Otherwise it runs alongside the CPU, one instruction per
+   instruction time: BATCH instructions per service call, up to the next
+   event, with the next call that many instruction times later.  Anything
+   the CPU must see - an APT dump on exit, trap or single step, and the
+   interrupt with it - clears run or sets pause, and ends the batch. */
 
 t_stat fpp_svc (UNIT *uptr)
 {
 FPN x;
 uint32 ir, op, op2, op3, ad, ea, wd;
-uint32 i;
+uint32 i, n;
 int32 sc;
 
 fpp_ac.exp = SEXT12 (fpp_ac.exp);                       /* sext AC exp */
+n = 0;
 do {                                                    /* repeat */
     ir = fpp_read (fpp_fpc);                            /* get instr */
     fpp_fpc = (fpp_fpc + 1) & ADDRMASK;                 /* incr FP PC */
@@ -737,10 +753,12 @@ do {                                                    /* repeat */
 
     if (sim_interval)
         sim_interval = sim_interval - 1;
+    n = n + 1;
     } while ((sim_interval > 0) && 
-             ((fpp_sta & (FPS_RUN|FPS_PAUSE|FPS_LOCK)) == (FPS_RUN|FPS_LOCK)));
+             (((fpp_sta & (FPS_RUN|FPS_PAUSE|FPS_LOCK)) == (FPS_RUN|FPS_LOCK)) ||
+              (((fpp_sta & (FPS_RUN|FPS_PAUSE)) == FPS_RUN) && (n < fpp_batch))));
 if ((fpp_sta & (FPS_RUN|FPS_PAUSE)) == FPS_RUN)
-    sim_activate (uptr, 1);
+    sim_activate (uptr, (fpp_sta & FPS_LOCK)? 1: n);    /* after the batch */
 fpp_ac.exp &= 07777;                                    /* mask AC exp */
 return SCPE_OK;
 }
@@ -1015,15 +1033,7 @@ if (fpp_fr_test (a->fr, 0, cnt) == 0) {                 /* zero? */
     a->exp = 0;                                         /* clean exp */
     return FALSE;                                       /* don't round */
     }
-while (((a->fr[0] == 0) && !(a->fr[1] & 04000)) ||      /* lead 13b same? */
-       ((a->fr[0] == 07777) && (a->fr[1] & 04000))) {
-    fpp_fr_lsh12 (a->fr, cnt);                          /* move word */
-    a->exp = a->exp - 12;
-    }
-while (((a->fr[0] ^ (a->fr[0] << 1)) & FPN_FRSIGN) == 0) { /* until norm */
-    fpp_fr_lsh1 (a->fr, cnt);                           /* shift 1b */
-    a->exp = a->exp - 1;
-    }
+a->exp = a->exp - fpp_fr_norm (a->fr, cnt);              /* shift to norm */
 if (fpp_fr_test (a->fr, 04000, EXACT) == 0) {           /* 4000...0000? */
     a->fr[0] = 06000;                                   /* chg to 6000... */
     a->exp = a->exp + 1;                                /* with exp+1 */
@@ -1104,7 +1114,37 @@ if (!(fpp_sta & FPS_DP) &&                          /* fp? */
 return;
 }
 
-/* N-precision integer routines */
+/* N-precision integer routines
+
+   Fractions of up to five words fit in 64b.  The fast routines pack them
+   into a t_uint64, most significant word first, and shift, add or
+   multiply in one step; the word by word routines, suffixed _ref, remain
+   the reference, and FPPCHECK compares the two on random operands.
+   Extended precision multiply and divide carry more than 64b, and always
+   use the reference routines. */
+
+#define FR_MASK(n)      ((((t_uint64) 1) << (n)) - 1)   /* low n bits, n < 64 */
+
+static t_uint64 fpp_fr_get (uint32 *a, uint32 cnt)
+{
+t_uint64 v = 0;
+uint32 i;
+
+for (i = 0; i < cnt; i++)
+    v = (v << 12) | a[i];
+return v;
+}
+
+static void fpp_fr_put (uint32 *a, t_uint64 v, uint32 cnt)
+{
+uint32 i;
+
+for (i = cnt; i > 0; i--) {
+    a[i - 1] = ((uint32) v) & 07777;
+    v = v >> 12;
+    }
+return;
+}
 
 /* Fraction add/sub */
 
@@ -1154,8 +1194,48 @@ return;
    If a-sign != c-sign, shift-in = result-sign
    */
 
+/* Fast fp/dp multiply.  The reference multiplies by one bit of b per step,
+   from the msb of b[1] and then of b[0], in a window of 3 and then 4
+   words, shifting the window left after each add.  Twelve such steps
+   with partial product C and multiplicand A leave C*2^12 + 2*A*b, modulo
+   the window; the bit shifted out of the last step is the sign carried
+   into the second window, which holds the first shifted right 24b, with
+   its low word dropped. */
+
 void fpp_fr_mul (uint32 *c, uint32 *a, uint32 *b, t_bool fix)
 {
+t_uint64 av, cv;
+uint32 fill, b_sign;
+
+if (fpp_sta & FPS_EP) {                             /* ep? */
+    fpp_fr_mul_ref (c, a, b, fix);
+    return;
+    }
+b_sign = b[0] & FPN_FRSIGN;                         /* remember b's sign */
+if (fix)
+    fpp_fr_algn (a, 12, FPN_NFR_MDS + 1);           /* fill left with sign */
+av = fpp_fr_get (a, 3);                             /* 36b window */
+cv = (2 * av * b[1]) & FR_MASK (37);                /* 12 steps, b[1] */
+fill = (cv >> 36)? 077777777: 0;                    /* sign shifted out */
+cv = (((t_uint64) fill) << 24) | ((cv & FR_MASK (36)) >> 12);
+av = fpp_fr_get (a, 4);                             /* 48b window */
+cv = ((cv << 12) + 2 * av * b[0]) & FR_MASK (48);   /* 12 steps, b[0] */
+fpp_fr_put (c, cv, 4);
+c[4] = c[5] = 0;
+b[0] = b[1] = 0;                                    /* mpyr shifted out */
+if (!fix)                                           /* imul shifts result */
+    fpp_fr_rsh1 (c, c[0] & FPN_FRSIGN, EXACT + 1);  /* result is 1 wd right */
+if (b_sign) {                                       /* if mpyr was negative */
+    if (fix)
+        fpp_fr_lsh12 (a, FPN_NFR_MDS+1);            /* restore a */
+    fpp_fr_sub (c, c, a, EXACT);                    /* adjust result */
+    fpp_fr_sub (c, c, a, EXACT);
+    }
+return;
+}
+
+void fpp_fr_mul_ref (uint32 *c, uint32 *a, uint32 *b, t_bool fix)
+{
 uint32 i, cnt, lo, wc, fill, b_sign;
 
 b_sign = b[0] & FPN_FRSIGN;                         /* remember b's sign */
@@ -1199,10 +1279,44 @@ if (b_sign) {                                       /* if mpyr was negative */
 return;
 }
 
-/* Fraction divide */
+/* Fraction divide
+
+   In fp and dp, the fractions are 24b and the words below are zero; they
+   stay zero through the steps of the divide, so the steps are done on
+   the high 24b alone. */
 
 t_bool fpp_fr_div (uint32 *c, uint32 *a, uint32 *b)
 {
+uint32 i, av, bv, q, sign, addsub, b_sign;
+
+if ((fpp_sta & FPS_EP) ||                           /* ep, or low words? */
+    ((a[2] | a[3] | a[4] | a[5] | b[2] | b[3] | b[4] | b[5]) != 0))
+    return fpp_fr_div_ref (c, a, b);
+sign = (a[0] ^ b[0]) & FPN_FRSIGN;                  /* sign of result */
+b_sign = (b[0] & FPN_FRSIGN);
+if (a[0] & FPN_FRSIGN)                              /* |a| */
+    fpp_fr_neg (a, EXACT);
+av = (a[0] << 12) | a[1];
+bv = (b[0] << 12) | b[1];
+addsub = 04000;                                     /* setup first op */
+for (i = 0, q = 0; i < 24; i++) {
+    if (addsub ^ b_sign)                            /* diff signs, subtr */
+        av = (av - bv) & 077777777;
+    else av = (av + bv) & 077777777;
+    addsub = (av & 040000000)? 0: 04000;            /* sign for nxt loop */
+    q = (q << 1) | (addsub >> 11);                  /* quo bit */
+    av = (av << 1) & 077777777;                     /* shift dividend */
+    }
+a[0] = av >> 12;
+a[1] = av & 07777;
+q = q & 077777777;
+fpp_fr_put (c, ((t_uint64) (sign? (0 - q): q)) << 36, EXTEND); /* -quo if neg */
+c[5] = 0;
+return ((q & 040000000) != 0);                      /* sign set before? */
+}
+
+t_bool fpp_fr_div_ref (uint32 *c, uint32 *a, uint32 *b)
+{
 uint32 i, old_c, lo, cnt, sign, b_sign, addsub, limit;
 /* Number of words processed by each divide step */
 static uint32 limits[7] = {6, 6, 5, 4, 3, 3, 2};
@@ -1357,6 +1471,21 @@ return;
 
 void fpp_fr_algn (uint32 *a, uint32 sc, uint32 cnt)
 {
+uint32 nb = cnt * 12;
+t_int64 v;
+
+if (cnt > 5) {                                      /* more than 64b? */
+    fpp_fr_algn_ref (a, sc, cnt);
+    return;
+    }
+v = (t_int64) (fpp_fr_get (a, cnt) << (64 - nb));   /* sign to bit 63 */
+v = v >> ((sc < nb)? (64 - nb + sc): 63);           /* shift, sext */
+fpp_fr_put (a, (t_uint64) v, cnt);
+return;
+}
+
+void fpp_fr_algn_ref (uint32 *a, uint32 sc, uint32 cnt)
+{
 uint32 i, sign;
 
 sign = (a[0] & FPN_FRSIGN)? 07777: 0;
@@ -1378,6 +1507,41 @@ a[0] = ((a[0] >> sc) | (sign << (12 - sc))) & 07777;
 return;
 }
 
+/* Normalize shift, of a nonzero fraction: left until the top two bits
+   differ, that is, up to the highest bit that differs from the bit below
+   it, with a 0 below the lsb.  Returns the shift count. */
+
+uint32 fpp_fr_norm (uint32 *a, uint32 cnt)
+{
+#if defined (__GNUC__)
+uint32 nb = cnt * 12, sc;
+t_uint64 v;
+
+v = fpp_fr_get (a, cnt);
+sc = __builtin_clzll ((v ^ (v << 1)) & FR_MASK (nb)) - (64 - nb);
+fpp_fr_put (a, v << sc, cnt);
+return sc;
+#else
+return fpp_fr_norm_ref (a, cnt);
+#endif
+}
+
+uint32 fpp_fr_norm_ref (uint32 *a, uint32 cnt)
+{
+uint32 sc = 0;
+
+while (((a[0] == 0) && !(a[1] & 04000)) ||          /* lead 13b same? */
+       ((a[0] == 07777) && (a[1] & 04000))) {
+    fpp_fr_lsh12 (a, cnt);                          /* move word */
+    sc = sc + 12;
+    }
+while (((a[0] ^ (a[0] << 1)) & FPN_FRSIGN) == 0) {  /* until norm */
+    fpp_fr_lsh1 (a, cnt);                           /* shift 1b */
+    sc = sc + 1;
+    }
+return sc;
+}
+
 /* Read/write routines */
 
 void fpp_read_op (uint32 ea, FPN *a)
@@ -1418,8 +1582,10 @@ void fpp_write (uint32 ea, uint32 val)
 ea = ea & ADDRMASK;
 if (fpp_cmd & FPC_FIXF)
     ea = fpp_aptsvf | (ea & 07777);
-if (MEM_ADDR_OK (ea))
+if (MEM_ADDR_OK (ea)) {
     M[ea] = val & 07777;
+    cpu_dma_wr (ea, 1);
+    }
 return;
 }
 
@@ -1432,8 +1598,10 @@ return M[ea];
 void apt_write (uint32 ea, uint32 val)
 {
 ea = ea & ADDRMASK;
-if (MEM_ADDR_OK (ea))
+if (MEM_ADDR_OK (ea)) {
     M[ea] = val & 07777;
+    cpu_dma_wr (ea, 1);
+    }
 return;
 }
 
@@ -1511,4 +1679,118 @@ else {
     }
 
 return SCPE_OK;
-}
+}
+
+/* Cross-check the fast fraction routines against their references
+
+   FPPCHECK {n}
+
+   runs n (default 1000000) sets of random operands through normalize
+   and align in fp, dp and ep, and through multiply and divide in fp and
+   dp, and prints the first mismatches.  Operand words favor 0, 4000 and
+   7777, where the carries and sign runs are. */
+
+static t_uint64 fpp_ck_seed = 1;
+
+static uint32 fpp_ck_word (void)
+{
+uint32 r;
+
+fpp_ck_seed ^= fpp_ck_seed << 13;                       /* xorshift */
+fpp_ck_seed ^= fpp_ck_seed >> 7;
+fpp_ck_seed ^= fpp_ck_seed << 17;
+r = (uint32) (fpp_ck_seed >> 20);
+switch (r & 07) {
+
+    case 0:
+        return 0;
+
+    case 1:
+        return 07777;
+
+    case 2:
+        return 04000;
+
+    default:
+        return (r >> 3) & 07777;
+        }
+}
+
+static void fpp_ck_bad (const char *op, uint32 *a, uint32 *b, uint32 *bad)
+{
+if ((*bad)++ < 10)
+    sim_printf ("%s %s: a=%04o %04o %04o %04o %04o b=%04o %04o %04o %04o %04o\n",
+        op, (fpp_sta & FPS_EP)? "ep": ((fpp_sta & FPS_DP)? "dp": "fp"),
+        a[0], a[1], a[2], a[3], a[4], b[0], b[1], b[2], b[3], b[4]);
+return;
+}
+
+t_stat fpp_check_cmd (int32 flag, char *cptr)
+{
+static const uint32 mode[3] = { 0, FPS_DP, FPS_EP };
+uint32 a[8], b[8], fa[8], fb[8], fc[8], ra[8], rb[8], rc[8];
+uint32 i, k, cnt, sc, n, bad = 0, sta = fpp_sta;
+t_bool fix;
+t_stat r;
+
+n = 1000000;
+if (*cptr != 0) {
+    n = (uint32) get_uint (cptr, 10, 0xFFFFFFFF, &r);
+    if (r != SCPE_OK)
+        return SCPE_ARG;
+    }
+for (i = 0; i < n; i++) {
+    fpp_sta = mode[i % 3];
+    for (k = 0; k < 8; k++) {
+        a[k] = fpp_ck_word ();
+        b[k] = fpp_ck_word ();
+        }
+    cnt = (i & 1)? EXTEND: EXACT;
+    if (fpp_fr_test (a, 0, cnt) != 0) {                 /* normalize */
+        memcpy (fa, a, sizeof (a));
+        memcpy (ra, a, sizeof (a));
+        if ((fpp_fr_norm (fa, cnt) != fpp_fr_norm_ref (ra, cnt)) ||
+            memcmp (fa, ra, sizeof (a)))
+            fpp_ck_bad ("normalize", a, b, &bad);
+        }
+    sc = b[0] % 70;                                     /* align */
+    memcpy (fa, a, sizeof (a));
+    memcpy (ra, a, sizeof (a));
+    fpp_fr_algn (fa, sc, cnt);
+    fpp_fr_algn_ref (ra, sc, cnt);
+    if (memcmp (fa, ra, sizeof (a)))
+        fpp_ck_bad ("align", a, b, &bad);
+    if (fpp_sta & FPS_EP)                               /* mul, div fp, dp */
+        continue;
+    for (k = FPN_NFR_FP; k < 8; k++)                    /* as fpp_zcopy */
+        a[k] = b[k] = 0;
+    for (fix = 0; fix < 2; fix++) {                     /* multiply */
+        memcpy (fa, a, sizeof (a));
+        memcpy (ra, a, sizeof (a));
+        memcpy (fb, b, sizeof (b));
+        memcpy (rb, b, sizeof (b));
+        memset (fc, 0, sizeof (fc));
+        memset (rc, 0, sizeof (rc));
+        fpp_fr_mul (fc, fa, fb, fix);
+        fpp_fr_mul_ref (rc, ra, rb, fix);
+        if (memcmp (fc, rc, sizeof (fc)) || memcmp (fa, ra, sizeof (a)) ||
+            memcmp (fb, rb, sizeof (b)))
+            fpp_ck_bad (fix? "multiply": "integer multiply", a, b, &bad);
+        }
+    if (fpp_fr_test (b, 0, EXACT) != 0) {               /* divide */
+        memcpy (fa, a, sizeof (a));
+        memcpy (ra, a, sizeof (a));
+        memcpy (fb, b, sizeof (b));
+        memcpy (rb, b, sizeof (b));
+        memset (fc, 0, sizeof (fc));
+        memset (rc, 0, sizeof (rc));
+        if ((fpp_fr_div (fc, fa, fb) != fpp_fr_div_ref (rc, ra, rb)) ||
+            memcmp (fc, rc, sizeof (fc)) || memcmp (fa, ra, sizeof (a)) ||
+            memcmp (fb, rb, sizeof (b)))
+            fpp_ck_bad ("divide", a, b, &bad);
+        }
+    }
+fpp_sta = sta;
+sim_printf ("FPP: %d operand sets, %d mismatches\n", n, bad);
+return bad? SCPE_IERR: SCPE_OK;
+}
@@ -130,7 +130,7 @@
 #define STA_DYN         (STA_REW | STA_BOT | STA_REM | STA_EOF | \
                          STA_EOT | STA_WLK)             /* kept in USTAT */
 
-extern uint16 M[];
+extern uint16 *M;
 extern int32 int_req, stop_inst;
 extern UNIT cpu_unit;
 
@@ -433,8 +433,10 @@ switch (f) {                                            /* case on function */
                 c2 = mtxb[p++] & 077;
                 c = (c1 << 6) | c2;
                 }
-            if ((f == FN_READ) && MEM_ADDR_OK (xma))
+            if ((f == FN_READ) && MEM_ADDR_OK (xma)) {
                 M[xma] = c;
+                cpu_dma_wr (xma, 1);
+                }
             else if ((f == FN_CMPARE) && (M[xma] != c)) {
                 mt_sta = mt_sta | STA_CPE | STA_ERR;
                 break;
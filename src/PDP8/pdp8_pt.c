@@ -280,7 +280,7 @@ static const uint16 boot_rom[] = {
 t_stat ptr_boot (int32 unitno, DEVICE *dptr)
 {
 size_t i;
-extern uint16 M[];
+extern uint16 *M;
 
 if (ptr_dib.dev != DEV_PTR)                             /* only std devno */
     return STOP_NOTSTD;
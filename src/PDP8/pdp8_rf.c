@@ -105,7 +105,8 @@
                             int_req = int_req | INT_RF; \
                         else int_req = int_req & ~INT_RF
 
-extern uint16 M[];
+extern uint16 *M;
+extern uint16 mem_home[];                               /* for REG tables */
 extern int32 int_req, stop_inst;
 extern UNIT cpu_unit;
 
@@ -149,8 +150,8 @@ UNIT pcell_unit = { UDATA (&pcell_svc, 0, 0) };
 REG rf_reg[] = {
     { ORDATA (STA, rf_sta, 12) },
     { ORDATA (DA, rf_da, 20) },
-    { ORDATA (WC, M[RF_WC], 12), REG_FIT },
-    { ORDATA (MA, M[RF_MA], 12), REG_FIT },
+    { ORDATA (WC, mem_home[RF_WC], 12), REG_FIT },
+    { ORDATA (MA, mem_home[RF_MA], 12), REG_FIT },
     { FLDATA (DONE, rf_done, 0) },
     { FLDATA (INT, int_req, INT_V_RF) },
     { ORDATA (WLK, rf_wlk, 32) },
@@ -322,10 +323,13 @@ do {
         }
     M[RF_WC] = (M[RF_WC] + 1) & 07777;                  /* incr word count */
     M[RF_MA] = (M[RF_MA] + 1) & 07777;                  /* incr mem addr */
+    cpu_dma_wr (RF_WC, 2);
     pa = mex | M[RF_MA];                                /* add extension */
     if (uptr->FUNC == RF_READ) {                        /* read? */
-        if (MEM_ADDR_OK (pa))                           /* if !nxm */
+        if (MEM_ADDR_OK (pa)) {                         /* if !nxm */
             M[pa] = fbuf[rf_da];                        /* read word */
+            cpu_dma_wr (pa, 1);
+            }
         }
     else {                                              /* write */
         t = ((rf_da >> 15) & 030) | ((rf_da >> 14) & 07);
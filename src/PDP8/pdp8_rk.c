@@ -126,7 +126,7 @@
 #define RK_MIN          50
 #define MAX(x,y)        (((x) > (y))? (x): (y))
 
-extern uint16 M[];
+extern uint16 *M;
 extern int32 int_req, stop_inst;
 extern UNIT cpu_unit;
 
@@ -378,12 +378,14 @@ if ((uptr->FUNC == RKC_READ) && (err == 0) && MEM_ADDR_OK (pa)) { /* read? */
     awc = fxread (&M[pa], sizeof (int16), wc, uptr->fileref);
     for ( ; awc < wc; awc++)                            /* fill if eof */
         M[pa + awc] = 0;
+    cpu_dma_wr (pa, wc);                                /* tell CPU */
     err = ferror (uptr->fileref);
     if ((wc1 > 0) && (err == 0))  {                     /* field wraparound? */
         pa = pa & 070000;                               /* wrap phys addr */
         awc = fxread (&M[pa], sizeof (int16), wc1, uptr->fileref);
         for ( ; awc < wc1; awc++)                       /* fill if eof */
             M[pa + awc] = 0;
+        cpu_dma_wr (pa, wc1);
         err = ferror (uptr->fileref);
         }
     }
@@ -155,7 +155,7 @@
 
 #define RLSI_V_TRK      6                               /* track */
 
-extern uint16 M[];
+extern uint16 *M;
 extern int32 int_req;
 extern UNIT cpu_unit;
 
@@ -487,6 +487,7 @@ if ((func >= RLCSB_READ) && (err == 0) &&               /* read (no hdr)? */
             }
         else M[ma] = rlxb[j] |                          /* even wd 12b */
             ((((uint16) rlxb[j + 1]) & 017) << 8);      
+        cpu_dma_wr (ma, 1);
         ma = (ma & 070000) + ((ma + 1) & 07777);
         }                                               /* end for */
     }                                                   /* end if wr */
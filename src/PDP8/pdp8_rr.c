@@ -0,0 +1,474 @@
+/* pdp8_rr.c: PDP-8 run recording and replay
+
+   RECORD file logs, from then on, every input that can make one run of the
+   simulator differ from another run started in the same state: console and
+   TTIX characters, TTIX connections, output stalls, clock calibrations,
+   idle sleeps, front panel switch changes, and attaches and detaches.  Each
+   is logged with the instruction count (sim_gtime) at which it was
+   delivered.  REPLAY file, issued in the same state, delivers the logged
+   inputs at the same instruction counts in place of the live ones, so the
+   run is reproduced exactly, however long it was and whatever the host was
+   doing, and stops at the instruction where NORECORD was given.
+
+   The state is the simulator's, not the host's: memory and the CPU are
+   checked when the replay starts, but disk images are not, so a recording
+   of a run that writes to its disks must be replayed against copies of
+   the images taken when the recording started.  The configuration (SET
+   commands) must also be the same, which is easiest if the RECORD and
+   REPLAY commands are issued from the same boot script.  Attaches and
+   detaches given at the sim> prompt while recording are made again by the
+   replay, at the same instruction; other commands given there, DEPOSIT
+   for one, are not logged.  During a replay live input is discarded,
+   except that ^E still stops the simulator.
+
+   The log is a header followed by events.  Numbers are unsigned LEB128, 7
+   bits to a byte, low order first, the high bit set on all but the last.
+
+        header  "PDP8RR", 0, 0, then numbers: version, start time, state
+                check, clock ticks/sec, clock delay, mux poll, switch rows,
+                panel flags
+        event   time since the previous event, type byte, value; RR_ATT
+                and RR_ATTC values are a length, and that many characters
+                follow
+
+   A typical event takes 3-5 bytes.  The event types are in pdp8_defs.h.
+*/
+
+#include "pdp8_defs.h"
+
+#define RR_VERSION      1
+#define RR_STRSIZE      (2 * CBUFSIZE)
+
+extern int32 saved_PC, saved_DF, saved_LAC, saved_MQ;
+extern int32 dev_done, int_enable, tmxr_poll;
+extern uint16 *M;
+extern UNIT cpu_unit;
+extern uint32 switchstatus[3];
+extern int swStop, swExam, swDep, swCont2, swStart, swSingStep, swAttach;
+
+char *sim_trim_endspc (char *cptr);
+
+int32 rr_mode = RR_OFF;                                 /* off, rec, play */
+uint32 rr_conn = 0;                                     /* TTIX lines up */
+
+static const char rr_magic[8] = "PDP8RR";
+static FILE *rr_file = NULL;                            /* log */
+static t_uint64 rr_last = 0;                            /* last event time */
+static t_uint64 rr_cnt = 0;                             /* events */
+static int32 rr_cal = 0;                                /* last clock delay */
+static t_uint64 rr_sw = 0;                              /* last switch rows */
+static t_uint64 rr_time = 0;                            /* replay: next event */
+static int32 rr_type = RR_END;
+static t_uint64 rr_val = 0;
+static char rr_str[RR_STRSIZE];
+static t_bool rr_busy = FALSE;                          /* replay attaching */
+
+#define RR_NOW          ((t_uint64) sim_gtime ())
+#define RR_SWPACK(s)    (((t_uint64) ((s)[2] & 0xFFFF) << 32) | \
+                        (((s)[1] & 0xFFFF) << 16) | ((s)[0] & 0xFFFF))
+
+/* Log I/O */
+
+static void rr_wnum (t_uint64 v)
+{
+while (v >= 0200) {
+    fputc ((int) ((v & 0177) | 0200), rr_file);
+    v = v >> 7;
+    }
+fputc ((int) v, rr_file);
+}
+
+static t_bool rr_rnum (t_uint64 *v)
+{
+int32 c, sh;
+
+*v = 0;
+for (sh = 0; sh < 64; sh = sh + 7) {
+    if ((c = getc (rr_file)) == EOF)
+        return FALSE;
+    *v = *v | ((t_uint64) (c & 0177) << sh);
+    if ((c & 0200) == 0)
+        return TRUE;
+    }
+return FALSE;
+}
+
+static void rr_log (t_uint64 t, int32 type, t_uint64 v)
+{
+rr_wnum (t - rr_last);
+fputc (type, rr_file);
+rr_wnum (v);
+rr_last = t;
+rr_cnt++;
+}
+
+/* Replay: read the next event.  A log that ends without RR_END, because
+   the recording simulator died, ends at its last event. */
+
+static void rr_next (void)
+{
+t_uint64 d, l;
+int32 c;
+
+rr_str[0] = 0;
+if (rr_rnum (&d) && ((c = getc (rr_file)) != EOF) && rr_rnum (&rr_val)) {
+    rr_time = rr_last = rr_last + d;
+    rr_type = c;
+    if ((c != RR_ATT) && (c != RR_ATTC))
+        return;
+    l = rr_val;
+    if ((l < RR_STRSIZE) && (fread (rr_str, 1, (size_t) l, rr_file) == l)) {
+        rr_str[l] = 0;
+        return;
+        }
+    }
+rr_time = rr_last;
+rr_type = RR_END;
+rr_val = 0;
+}
+
+static void rr_close (void)
+{
+if (rr_file != NULL)
+    fclose (rr_file);
+rr_file = NULL;
+rr_mode = RR_OFF;
+}
+
+static void rr_diverge (const char *what)
+{
+sim_printf ("Replay diverged at %.0f: %s, next logged event type %d at %.0f\n",
+    sim_gtime (), what, rr_type, (double) rr_time);
+rr_close ();
+stop_cpu = 1;                                           /* stop soon */
+}
+
+/* Replay: make an attach or detach that was given at the sim> prompt */
+
+static void rr_console (void)
+{
+char buf[RR_STRSIZE];
+t_stat r;
+
+strcpy (buf, rr_str);
+rr_cnt++;
+rr_next ();
+rr_busy = TRUE;
+sim_switches = 0;
+if (strncmp (buf, "ATTACH ", 7) == 0)
+    r = attach_cmd (0, buf + 7);
+else r = detach_cmd (0, buf + 7);
+rr_busy = FALSE;
+if (r != SCPE_OK)
+    rr_diverge (buf);
+}
+
+/* Replay: is the next event of this type, and due now?  An event that is
+   overdue was not asked for when it was recorded, so the run has taken a
+   different path.  Console attaches come between events, and are made as
+   soon as they are reached. */
+
+static t_bool rr_peek (int32 type)
+{
+t_uint64 now;
+
+now = RR_NOW;
+while ((rr_mode == RR_PLAY) && (rr_time == now) && (rr_type == RR_ATTC))
+    rr_console ();
+if (rr_mode != RR_PLAY)
+    return FALSE;
+if (rr_time < now) {
+    rr_diverge ("event overdue");
+    return FALSE;
+    }
+return ((rr_time == now) && (rr_type == type));
+}
+
+static t_bool rr_match (int32 type, t_uint64 *v)
+{
+if (!rr_peek (type))
+    return FALSE;
+*v = rr_val;
+rr_cnt++;
+rr_next ();
+return TRUE;
+}
+
+static t_bool rr_end (void)
+{
+if (!rr_peek (RR_END))
+    return FALSE;
+sim_printf ("Replay complete at %.0f, %.0f events\n", sim_gtime (), (double) rr_cnt);
+rr_close ();
+return TRUE;
+}
+
+/* Nondeterministic input.  Recording, a nonzero value is logged; replaying,
+   the value logged now is returned, or zero.  See RR_INPUT. */
+
+int32 rr_input (int32 type, int32 val)
+{
+t_uint64 v;
+
+if (rr_mode == RR_REC) {
+    if (val != 0)
+        rr_log (RR_NOW, type, (uint32) val);
+    return val;
+    }
+if (rr_mode == RR_PLAY)
+    return rr_match (type, &v)? (int32) v: 0;
+return val;
+}
+
+/* Clock calibration.  The result changes about once a second; only the
+   changes are logged.  In replay the timer is told the logged delay, so
+   that sim_activate_after agrees with the recording as well. */
+
+int32 rr_calb (int32 ticksper, int32 tmr)
+{
+t_uint64 v;
+int32 t;
+
+t = sim_rtcn_calb (ticksper, tmr);
+if (rr_mode == RR_PLAY) {
+    if (rr_match (RR_CAL, &v))
+        rr_cal = (int32) v;
+    sim_rtcn_set_cal (tmr, ticksper, rr_cal);
+    return rr_cal;
+    }
+if ((rr_mode == RR_REC) && (t != rr_cal)) {
+    rr_log (RR_NOW, RR_CAL, (uint32) t);
+    rr_cal = t;
+    }
+return t;
+}
+
+/* Idle.  The instructions skipped depend on how long the host slept; the
+   event is logged at the instruction count before the skip.  In replay
+   nothing sleeps. */
+
+t_bool rr_idle (uint32 tmr)
+{
+t_uint64 t, v;
+int32 iv;
+
+t = RR_NOW;
+if (rr_mode == RR_PLAY) {
+    if (!rr_match (RR_IDLE, &v))
+        return FALSE;
+    sim_interval = sim_interval - (int32) v;
+    return TRUE;
+    }
+iv = sim_interval;
+if (!sim_idle (tmr, FALSE))
+    return FALSE;
+if (rr_mode == RR_REC)
+    rr_log (t, RR_IDLE, (uint32) (iv - sim_interval));
+return TRUE;
+}
+
+/* Front panel, called each time the CPU reads the switch rows.  Recording,
+   changes are logged.  Replaying, the CPU calls this on every pass instead
+   of reading the panel; it delivers the logged rows, and stops the
+   simulator where the recording ended. */
+
+t_stat rr_panel (uint32 *sw)
+{
+t_uint64 v;
+
+if (rr_mode == RR_REC) {
+    v = RR_SWPACK (sw);
+    if (v != rr_sw) {
+        rr_log (RR_NOW, RR_SW, v);
+        rr_sw = v;
+        }
+    return SCPE_OK;
+    }
+if (rr_match (RR_SW, &v)) {
+    sw[0] = (uint32) (v & 0xFFFF);
+    sw[1] = (uint32) ((v >> 16) & 0xFFFF);
+    sw[2] = (uint32) ((v >> 32) & 0xFFFF);
+    }
+return rr_end ()? SCPE_STOP: SCPE_OK;
+}
+
+/* Simulator stopped.  Recording, the log is flushed, so that it survives a
+   simulator that is killed rather than stopped; replaying, the recording
+   may have ended here. */
+
+void rr_stop (void)
+{
+if (rr_mode == RR_REC)
+    fflush (rr_file);
+else rr_end ();
+}
+
+/* Attach and detach (sim_vm_attach), logged as the command that would make
+   them.  Replaying, one made while the simulator runs - a mount from the
+   panel - must be made again at the same point, by the replayed run; one
+   made at the sim> prompt is made by the replay itself (rr_console). */
+
+void rr_attach (UNIT *uptr, char *cptr)
+{
+char buf[RR_STRSIZE];
+int32 i, l;
+
+if ((rr_mode == RR_OFF) || rr_busy)
+    return;
+l = snprintf (buf, sizeof (buf), "%s %s", cptr? "ATTACH": "DETACH", sim_uname (uptr));
+for (i = 0; cptr && !sim_is_running && (i < 26); i++) {  /* switches given */
+    if ((sim_switches & (1u << i)) && (l < (int32) sizeof (buf) - 4))
+        l = l + sprintf (buf + l, " -%c", 'A' + i);
+    }
+if (cptr != NULL)
+    snprintf (buf + l, sizeof (buf) - l, " %s", cptr);
+if (rr_mode == RR_REC) {
+    rr_log (RR_NOW, sim_is_running? RR_ATT: RR_ATTC, strlen (buf));
+    fputs (buf, rr_file);
+    fflush (rr_file);
+    return;
+    }
+if (rr_peek (RR_ATT) && (strcmp (buf, rr_str) == 0)) {
+    rr_cnt++;
+    rr_next ();
+    return;
+    }
+if (rr_mode == RR_PLAY)
+    rr_diverge (buf);
+}
+
+/* Replaying, the file attached to device dev now, if any; the panel
+   mounts it instead of searching for one */
+
+char *rr_mount (const char *dev)
+{
+size_t l = strlen (dev);
+
+if (rr_peek (RR_ATT) && (strncmp (rr_str, "ATTACH ", 7) == 0) &&
+    (strncasecmp (rr_str + 7, dev, l) == 0) && (rr_str[l + 7] == ' '))
+    return rr_str + l + 8;
+return NULL;
+}
+
+/* State check: memory and the CPU registers, FNV-1a */
+
+static uint32 rr_check (void)
+{
+uint32 i, h = 2166136261u;
+int32 r[6];
+
+r[0] = saved_PC;
+r[1] = saved_DF;
+r[2] = saved_LAC;
+r[3] = saved_MQ;
+r[4] = dev_done;
+r[5] = int_enable;
+for (i = 0; i < MEMSIZE; i++)
+    h = (h ^ M[i]) * 16777619u;
+for (i = 0; i < 6; i++)
+    h = (h ^ (uint32) r[i]) * 16777619u;
+return h;
+}
+
+/* RECORD file, NORECORD */
+
+t_stat rr_record_cmd (int32 flag, char *cptr)
+{
+int32 hz = 0, currd = 0;
+
+if (rr_mode == RR_PLAY)
+    return sim_messagef (SCPE_ARG, "Replay in progress\n");
+if (rr_mode == RR_REC) {                                /* end recording */
+    rr_log (RR_NOW, RR_END, 0);
+    sim_printf ("Recorded %.0f events, %ld bytes\n", (double) rr_cnt, ftell (rr_file));
+    rr_close ();
+    }
+if (flag == 0)                                          /* NORECORD? */
+    return SCPE_OK;
+if ((cptr == NULL) || (*cptr == 0))
+    return SCPE_2FARG;
+if (sim_asynch_enabled)                                 /* events not in order */
+    return sim_messagef (SCPE_NOFNC, "Asynchronous I/O is enabled, SET NOASYNCH first\n");
+sim_trim_endspc (cptr);
+if ((rr_file = sim_fopen (cptr, "wb")) == NULL)
+    return SCPE_OPENERR;
+sim_rtcn_get_cal (TMR_CLK, &hz, &currd);
+rr_last = RR_NOW;
+rr_cnt = 0;
+rr_cal = currd;
+rr_sw = RR_SWPACK (switchstatus);
+rr_conn = 0;
+fwrite (rr_magic, 1, sizeof (rr_magic), rr_file);
+rr_wnum (RR_VERSION);
+rr_wnum (rr_last);
+rr_wnum (rr_check ());
+rr_wnum ((uint32) hz);
+rr_wnum ((uint32) currd);
+rr_wnum ((uint32) tmxr_poll);
+rr_wnum (rr_sw);
+rr_wnum ((swStop << 6) | (swExam << 5) | (swDep << 4) | (swCont2 << 3) |
+    (swStart << 2) | (swSingStep << 1) | swAttach);
+rr_mode = RR_REC;
+return SCPE_OK;
+}
+
+/* REPLAY file, NOREPLAY */
+
+t_stat rr_replay_cmd (int32 flag, char *cptr)
+{
+char mg[sizeof (rr_magic)];
+t_uint64 h[8];
+uint32 i;
+
+if (rr_mode == RR_REC)
+    return sim_messagef (SCPE_ARG, "Recording in progress\n");
+rr_close ();
+if (flag == 0)                                          /* NOREPLAY? */
+    return SCPE_OK;
+if ((cptr == NULL) || (*cptr == 0))
+    return SCPE_2FARG;
+if (sim_asynch_enabled)
+    return sim_messagef (SCPE_NOFNC, "Asynchronous I/O is enabled, SET NOASYNCH first\n");
+sim_trim_endspc (cptr);
+if ((rr_file = sim_fopen (cptr, "rb")) == NULL)
+    return SCPE_OPENERR;
+if ((fread (mg, 1, sizeof (mg), rr_file) != sizeof (mg)) ||
+    memcmp (mg, rr_magic, sizeof (mg))) {
+    rr_close ();
+    return sim_messagef (SCPE_FMT, "Not a recording: %s\n", cptr);
+    }
+for (i = 0; i < 8; i++) {
+    if (!rr_rnum (&h[i])) {
+        rr_close ();
+        return SCPE_IOERR;
+        }
+    }
+if (h[0] != RR_VERSION) {
+    rr_close ();
+    return sim_messagef (SCPE_INCOMP, "Recording version %.0f, expected %d\n",
+        (double) h[0], RR_VERSION);
+    }
+if ((h[1] != RR_NOW) || (h[2] != rr_check ())) {
+    rr_close ();
+    return sim_messagef (SCPE_INCOMP, "Simulator state differs from the start of the recording\n");
+    }
+sim_rtcn_set_cal (TMR_CLK, (int32) h[3], (int32) h[4]);
+tmxr_poll = (int32) h[5];
+switchstatus[0] = (uint32) (h[6] & 0xFFFF);
+switchstatus[1] = (uint32) ((h[6] >> 16) & 0xFFFF);
+switchstatus[2] = (uint32) ((h[6] >> 32) & 0xFFFF);
+swStop = (h[7] >> 6) & 1;
+swExam = (h[7] >> 5) & 1;
+swDep = (h[7] >> 4) & 1;
+swCont2 = (h[7] >> 3) & 1;
+swStart = (h[7] >> 2) & 1;
+swSingStep = (h[7] >> 1) & 1;
+swAttach = h[7] & 1;
+rr_cal = (int32) h[4];
+rr_conn = 0;
+rr_last = h[1];
+rr_cnt = 0;
+rr_mode = RR_PLAY;
+rr_next ();
+return SCPE_OK;
+}
@@ -736,7 +736,7 @@ static const uint16 boot2_rom[] = {
 t_stat rx_boot (int32 unitno, DEVICE *dptr)
 {
 size_t i;
-extern uint16 M[];
+extern uint16 *M;
 
 if (rx_dib.dev != DEV_RX)                               /* only std devno */
     return STOP_NOTSTD;
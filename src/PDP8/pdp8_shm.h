@@ -0,0 +1,67 @@
+/* pdp8_shm.h: PDP-8 shared memory export layout
+
+   This header describes the segment created by SET CPU SHM=name, and is
+   meant to be included by the tools that read it as well as by the
+   simulator, so it depends on nothing but <stdint.h>.
+
+   The segment is a POSIX shared memory object, /name, laid out as
+
+        offset 0                SHM_HDR
+        offset SHM_MEMOFF       memory, shm_mem words of uint16_t
+
+   The memory part is the simulator's main memory itself, mapped into the
+   segment, so a reader sees every store as it happens, at no cost to the
+   simulator.  Words are stored whole, but there is no consistency between
+   words: a reader that needs a stable picture of a table should stop the
+   simulator, or check the table twice.
+
+   The registers are published each time the simulator services its event
+   queue, and when it stops.  So while it runs they lag the processor by up
+   to the time to the next event.  That is at most a keyboard poll interval,
+   which is one clock tick (1/60 s of simulated time), since the console
+   keyboard is always polled.  To read registers that agree with memory,
+   stop the simulator and wait for SHM_RUN to be zero.  They are double
+   buffered behind a sequence word, as the front panel state is
+   (see gpio.h): the writer fills the buffer that is not published, then
+   stores shm_seq + 2.  shm_seq is always even, and buffer SHM_BUF (seq)
+   is the one published at seq.  A reader does
+
+        do {
+            s = load_acquire (&h->shm_seq);
+            memcpy (regs, h->shm_reg[SHM_BUF (s)], sizeof (regs));
+            fence_acquire ();
+            } while (s != load_relaxed (&h->shm_seq));
+
+   and should map the segment read only.  A reader must check shm_magic and
+   shm_version; the version changes whenever the layout does.
+*/
+
+#ifndef PDP8_SHM_H_
+#define PDP8_SHM_H_     0
+
+#include <stdint.h>
+
+#define SHM_MAGIC       "PDP8SHM"
+#define SHM_VERSION     1
+#define SHM_MEMOFF      65536                           /* memory offset */
+
+#define SHM_BUF(seq)    (((seq) >> 1) & 1)              /* buffer published at seq */
+
+#define SHM_PC          0                               /* IF'PC */
+#define SHM_DF          1                               /* DF, in <14:12> */
+#define SHM_LAC         2                               /* L'AC */
+#define SHM_MQ          3                               /* MQ */
+#define SHM_INTREQ      4                               /* interrupt requests */
+#define SHM_RUN         5                               /* nonzero if running */
+#define SHM_NREG        8
+
+typedef struct {
+    char                shm_magic[8];                   /* SHM_MAGIC */
+    uint32_t            shm_version;                    /* SHM_VERSION */
+    uint32_t            shm_mem;                        /* words at SHM_MEMOFF */
+    uint32_t            shm_msize;                      /* memory configured */
+    uint32_t            shm_seq;                        /* register sequence */
+    uint32_t            shm_reg[2][SHM_NREG];           /* register buffers */
+    } SHM_HDR;
+
+#endif
@@ -65,13 +65,20 @@ extern DEVICE dt_dev, td_dev;
 extern DEVICE mt_dev, ct_dev;
 extern DEVICE ttix_dev, ttox_dev;
 extern REG cpu_reg[];
-extern uint16 M[];
+extern uint16 *M;
+extern OPRDEC opr_dec[];
 
 t_stat fprint_sym_fpp (FILE *of, t_value *val);
 t_stat parse_sym_fpp (char *cptr, t_value *val);
 char *parse_field (char *cptr, uint32 max, uint32 *val, uint32 c);
 char *parse_fpp_xr (char *cptr, uint32 *xr, t_bool inc);
 int32 test_fpp_addr (uint32 ad, uint32 max);
+t_stat cpu_hdump_cmd (int32 flag, char *cptr);
+t_stat cpu_eaecheck_cmd (int32 flag, char *cptr);
+t_stat fpp_check_cmd (int32 flag, char *cptr);
+t_stat rr_record_cmd (int32 flag, char *cptr);
+t_stat rr_replay_cmd (int32 flag, char *cptr);
+void pdp8_vm_init (void);
 
 /* SCP data structures and interface routines
 
@@ -82,6 +89,7 @@ int32 test_fpp_addr (uint32 ad, uint32 max);
    sim_consoles         array of pointers to consoles (if more than one)
    sim_stop_messages    array of pointers to stop messages
    sim_load             binary loader
+   sim_vm_cmd           simulator specific commands
 */
 
 char sim_name[] = "PDP-8";
@@ -122,9 +130,39 @@ const char *sim_stop_messages[] = {
     "Opcode Breakpoint",
     "Non-standard device number",
     "DECtape off reel",
-    "Infinite loop"
+    "Infinite loop",
+    "Read breakpoint",
+    "Write breakpoint"
     };
 
+CTAB pdp8_cmd[] = {
+    { "HDUMP", &cpu_hdump_cmd, 0,
+      "hdump <file> {n} {PC=lo{-hi}} {IR=val{/mask}}\n"
+      "                         decode a CPU history file (see SET CPU HFILE)\n" },
+    { "EAECHECK", &cpu_eaecheck_cmd, 0,
+      "eaecheck                 cross-check the EAE kernels against their references\n" },
+    { "FPPCHECK", &fpp_check_cmd, 0,
+      "fppcheck {n}             cross-check the FPP fraction routines on n operands\n" },
+    { "RECORD", &rr_record_cmd, 1,
+      "record <file>            log the inputs of the run from here on to file\n" },
+    { "NORECORD", &rr_record_cmd, 0,
+      "norecord                 stop recording\n" },
+    { "REPLAY", &rr_replay_cmd, 1,
+      "replay <file>            replay a recorded run, from the state it started in\n" },
+    { "NOREPLAY", &rr_replay_cmd, 0,
+      "noreplay                 abandon a replay\n" },
+    { NULL }
+    };
+
+void (*sim_vm_init) (void) = &pdp8_vm_init;
+
+void pdp8_vm_init (void)
+{
+sim_vm_cmd = pdp8_cmd;
+sim_vm_attach = &rr_attach;
+return;
+}
+
 /* Ambiguous device list - these devices have overlapped IOT codes */
 
 DEVICE *amb_dev[] = {
@@ -529,6 +567,56 @@ static const int32 fop_val[] = {
 #define fputs(_s,f) Fprintf(f,"%s",_s)
 #define fputc(_c,f) Fprintf(f,"%c",_c)
 
+/* Operate group 1 and 2 decode, driven by the CPU's decoded OPR table */
+
+static const char *opr_rot[16] = {
+    NULL, "RAL", "RTL", NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, "RTR", "RAR", "BSW", "RAL RAR", "RTL RTR"
+    };
+
+static const char *opr_skp[16] = {
+    NULL, "SKP", "SNL", "SZL", "SZA", "SNA", "SZA SNL", "SNA SZL",
+    "SMA", "SPA", "SMA SNL", "SPA SZL", "SMA SZA", "SPA SNA",
+    "SMA SZA SNL", "SPA SNA SZL"
+    };
+
+int32 fprint_opr_dec (FILE *of, int32 inst, int32 sp)
+{
+OPRDEC *p = &opr_dec[inst & 0777];
+const char *name[8];
+int32 i, n = 0;
+
+if ((inst & 0400) == 0) {                               /* group 1 */
+    if ((p->andm & 07777) == 0)
+        name[n++] = "CLA";
+    if ((p->andm & 010000) == 0)
+        name[n++] = "CLL";
+    if (p->xorm & 07777)
+        name[n++] = "CMA";
+    if (p->xorm & 010000)
+        name[n++] = "CML";
+    if (p->iac)
+        name[n++] = "IAC";
+    if (opr_rot[p->rot])
+        name[n++] = opr_rot[p->rot];
+    }
+else {                                                  /* group 2 */
+    if (opr_skp[p->flg & OPR_M_SNS])
+        name[n++] = opr_skp[p->flg & OPR_M_SNS];
+    if ((p->andm & 07777) == 0)
+        name[n++] = "CLA";
+    if (p->flg & OPR_OSR)
+        name[n++] = "OAS";
+    if (p->flg & OPR_HLT)
+        name[n++] = "HLT";
+    }
+for (i = 0; i < n; i++) {
+    fprintf (of, (sp? " %s": "%s"), name[i]);
+    sp = 1;
+    }
+return sp;
+}
+
 int32 fprint_opr (FILE *of, int32 inst, int32 class, int32 sp)
 {
 int32 i, j;
@@ -642,16 +730,9 @@ for (i = 0; opc_val[i] >= 0; i++) {                     /* loop thru ops */
             break;
 
         case I_V_OP1:                                   /* operate group 1 */
-            sp = fprint_opr (of, inst & 0361, j, 0);
-            if (opcode[i])
-                fprintf (of, (sp? " %s": "%s"), opcode[i]);
-            break;
-
         case I_V_OP2:                                   /* operate group 2 */
-            if (opcode[i])
-                fprintf (of, "%s", opcode[i]); /* skips */
-            fprint_opr (of, inst & 0206, j, opcode[i] != NULL);
-            break;      
+            fprint_opr_dec (of, inst, 0);
+            break;
 
         case I_V_OP3:                                   /* operate group 3 */
             sp = fprint_opr (of, inst & 0320, j, 0);
@@ -210,7 +210,7 @@ void td_write (UNIT *uptr, int32 blk, int32 line, int32 datb);
 int32 td_set_mtk (int32 code, int32 u, int32 k);
 t_stat td_show_pos (FILE *st, UNIT *uptr, int32 val, void *desc);
 
-extern uint16 M[];
+extern uint16 *M;
 
 /* TD data structures
 
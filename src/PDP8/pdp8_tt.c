@@ -181,7 +181,10 @@ int32 c;
 sim_clock_coschedule (uptr, tmxr_poll);                 /* continue poll */
 if (dev_done & INT_TTI)                                 /* prior character still pending? */
     return SCPE_OK;
-if ((c = sim_poll_kbd ()) < SCPE_KFLAG)                 /* no char or error? */
+c = sim_poll_kbd ();                                    /* poll keyboard */
+if (rr_mode && ((c == SCPE_OK) || (c >= SCPE_KFLAG)))  /* not ^E: record, replay */
+    c = rr_input (RR_TTI, c);
+if (c < SCPE_KFLAG)                                     /* no char or error? */
     return c;
 if (c & SCPE_BREAK)                                     /* break? */
     uptr->buf = 0;
@@ -196,6 +199,7 @@ return SCPE_OK;
 
 t_stat tti_reset (DEVICE *dptr)
 {
+tti_unit.dynflags |= TMUF_NOASYNCH;                     /* poll on the clock */
 tmxr_set_console_units (&tti_unit, &tto_unit);
 tti_unit.buf = 0;
 dev_done = dev_done & ~INT_TTI;                         /* clear done, int */
@@ -250,7 +254,17 @@ t_stat r;
 
 c = sim_tt_outcvt (uptr->buf, TT_GET_MODE (uptr->flags) | TTUF_KSR);
 if (c >= 0) {
-    if ((r = sim_putchar_s (c)) != SCPE_OK) {           /* output char; error? */
+    if (rr_mode == RR_PLAY) {                           /* stall as recorded */
+        r = rr_input (RR_TTO, 0);
+        if (r == SCPE_OK)                               /* output only once */
+            sim_putchar_s (c);
+        }
+    else {
+        r = sim_putchar_s (c);                          /* output char */
+        if (rr_mode)                                    /* record stall */
+            r = rr_input (RR_TTO, r);
+        }
+    if (r != SCPE_OK) {                                 /* error? */
         sim_activate (uptr, uptr->wait);                /* try again */
         return ((r == SCPE_STALL)? SCPE_OK: r);         /* if !stall, report */
         }
@@ -80,6 +80,7 @@ t_stat ttox_reset (DEVICE *dptr);
 t_stat ttx_attach (UNIT *uptr, char *cptr);
 t_stat ttx_detach (UNIT *uptr);
 void ttx_enbdis (int32 dis);
+t_bool ttx_conn (int32 ln);
 
 /* TTIx data structures
 
@@ -239,6 +240,19 @@ switch (pulse) {                                        /* case IR<9:11> */
 return AC;
 }
 
+/* Line connected?  Lines connect and disconnect at the whim of the network,
+   so when recording or replaying a run, changes are logged or replayed,
+   and the state is kept in rr_conn. */
+
+t_bool ttx_conn (int32 ln)
+{
+if (rr_mode == RR_OFF)
+    return (ttx_ldsc[ln].conn != 0);
+if (RR_INPUT (RR_TTXC + ln, (ttx_ldsc[ln].conn != 0) != ((rr_conn >> ln) & 1)))
+    rr_conn = rr_conn ^ (1u << ln);                     /* changed */
+return ((rr_conn >> ln) & 1);
+}
+
 /* Unit service */
 
 t_stat ttix_svc (UNIT *uptr)
@@ -248,15 +262,17 @@ int32 ln, c, temp;
 if ((uptr->flags & UNIT_ATT) == 0)                      /* attached? */
     return SCPE_OK;
 sim_clock_coschedule (uptr, tmxr_poll);                 /* continue poll */
-ln = tmxr_poll_conn (&ttx_desc);                        /* look for connect */
-if (ln >= 0)                                            /* got one? rcv enb*/
-    ttx_ldsc[ln].rcve = 1;
-tmxr_poll_rx (&ttx_desc);                               /* poll for input */
+if (rr_mode != RR_PLAY) {                               /* live lines? */
+    ln = tmxr_poll_conn (&ttx_desc);                    /* look for connect */
+    if (ln >= 0)                                        /* got one? rcv enb*/
+        ttx_ldsc[ln].rcve = 1;
+    tmxr_poll_rx (&ttx_desc);                           /* poll for input */
+    }
 for (ln = 0; ln < TTX_LINES; ln++) {                    /* loop thru lines */
-    if (ttx_ldsc[ln].conn) {                            /* connected? */
+    if (ttx_conn (ln)) {                                /* connected? */
         if (dev_done & (INT_TTI1 << ln))                /* Last character still pending? */
             continue;
-        if ((temp = tmxr_getc_ln (&ttx_ldsc[ln]))) {    /* get char */
+        if ((temp = RR_INPUT (RR_TTIX + ln, tmxr_getc_ln (&ttx_ldsc[ln])))) { /* get char */
             if (temp & SCPE_BREAK)                      /* break? */
                 c = 0;
             else c = sim_tt_inpcvt (temp, TT_GET_MODE (ttox_unit[ln].flags));
@@ -337,8 +353,8 @@ t_stat ttox_svc (UNIT *uptr)
 {
 int32 c, ln = uptr - ttox_unit;                         /* line # */
 
-if (ttx_ldsc[ln].conn) {                                /* connected? */
-    if (ttx_ldsc[ln].xmte) {                            /* tx enabled? */
+if (ttx_conn (ln)) {                                    /* connected? */
+    if (!RR_INPUT (RR_TTOX + ln, !ttx_ldsc[ln].xmte)) { /* tx enabled? */
         TMLN *lp = &ttx_ldsc[ln];                       /* get line */
         c = sim_tt_outcvt (ttox_buf[ln], TT_GET_MODE (ttox_unit[ln].flags));
         if (c >= 0)                                     /* output char */
@@ -4,9 +4,11 @@
  * 
  * www.obsolescenceguaranteed.blogspot.com
  * 
- * The only communication with the main program (simh):
- * - external variable ledstatus is read to determine which leds to light.
- * - external variable switchstatus is updated with current switch settings.
+ * The only communication with the main program (simh), see gpio.h:
+ * - ledpub is read to determine which leds to light.
+ * - ledreq is set to ask the CPU for a new ledpub sample.
+ * - in GLOW mode, glowpub holds the LED on-counts of the last frame.
+ * - swpub is published with the current switch settings whenever they change.
  * 
 */
 
@@ -32,8 +34,11 @@ struct bcm2835_peripheral gpio;	// needs initialisation
 
 long intervl = 300000;		// light each row of leds this long
 
-uint32 switchstatus[3] = { 0 }; // bitfields: 3 rows of up to 12 switches
-uint32 ledstatus[8] = { 0 };	// bitfields: 8 ledrows of up to 12 LEDs
+ledpub_t ledpub;		// bitfields: 8 ledrows of up to 12 LEDs, published by the CPU
+swpub_t swpub;			// bitfields: 3 rows of up to 12 switches, published here
+glowpub_t glowpub;		// GLOW mode: on-counts of the last frame, published by the CPU
+volatile int ledglow = 0;	// GLOW mode on (set by the CPU)
+volatile uint32 ledreq = 0;	// set at the start of every frame: CPU, please sample
 
 // PART 1 - GPIO and RT process stuff ----------------------------------
 
@@ -88,9 +93,53 @@ uint8_t cols[] = {13, 12, 11,    10, 9, 8,    7, 6, 5,    4, 15, 14};
 #endif
 
 
+// Fill onmask[s][row] with the LEDs to light in each sub-frame s, and return the number of
+// sub-frames. Without a GLOW frame there is one sub-frame, showing the last LED sample.
+// In GLOW mode an LED lit in n of the frame's samples gets brightness level
+// n * LED_LEVELS / samples (rounded), and is lit in that many of the LED_LEVELS sub-frames.
+int glow_masks(uint32 onmask[LED_LEVELS][8])
+{
+	static ledacc_t f;
+	int i, k, p, s, level;
+	uint32 count;
+
+	if (ledglow)				// take copies before asking for the next frame
+		panel_read(&glowpub.seq, glowpub.buf, sizeof(glowpub.buf[0]), &f);
+	panel_read(&ledpub.seq, ledpub.buf, sizeof(ledpub.buf[0]), onmask[0]);
+	ledreq = 1;				// ask for a fresh sample for the next frame
+	if (!ledglow || f.samples == 0)		// one sub-frame, as sampled
+		return 1;
+	for (i=0;i<8;i++)
+	{	for (s=0;s<LED_LEVELS;s++)
+			onmask[s][i] = 0;
+		for (k=0;k<12;k++)
+		{	count = 0;
+			for (p=0;p<LED_PLANES;p++)
+				count |= (uint32) ((f.plane[i/4][p] >> ((i%4)*12 + k)) & 1) << p;
+			level = (count * LED_LEVELS + f.samples/2) / f.samples;
+			for (s=0;s<level;s++)
+				onmask[s][i] |= 1<<k;
+		}
+	}
+	return LED_LEVELS;
+}
+
+// No panel (pidp8 -n): publish all switches up, once, so the CPU sees a panel at rest and
+// never scans it again. The LEDs are still sampled but nobody reads them.
+void panel_none(void)
+{
+	uint32 *swbuf = panel_next(&swpub.seq, swpub.buf, sizeof(swpub.buf[0]));
+
+	swbuf[0] = swbuf[1] = swbuf[2] = 07777;
+	panel_publish(&swpub.seq);
+}
+
 void *blink(int *terminate)
 {
 	int i,j,k,switchscan, tmp;
+	int s, nsub;
+	uint32 onmask[LED_LEVELS][8];
+	uint32 switchstatus[3] = { 0 }, *swbuf;
 
 	// Find gpio address (different for Pi 2) ----------
 	gpio.addr_p = bcm_host_get_peripheral_address() +  + 0x200000;
@@ -170,13 +219,16 @@ void *blink(int *terminate)
 			OUT_GPIO(cols[i]);			// Define cols as output
 		}
 		
-		// light up 8 rows of 12 LEDs each
+		nsub = glow_masks(onmask);		// LEDs to light, per sub-frame
+
+		// light up 8 rows of 12 LEDs each, nsub times
+		for (s=0;s<nsub;s++)
 		for (i=0;i<8;i++)
 		{
 
 			// Toggle columns for this ledrow (which LEDs should be on (CLR = on))
 			for (k=0;k<12;k++)
-			{	if ((ledstatus[i]&(1<<k))==0)
+			{	if ((onmask[s][i]&(1<<k))==0)
 					GPIO_SET = 1 << cols[k];
 				else 
 					GPIO_CLR = 1 << cols[k];
@@ -190,7 +242,7 @@ void *blink(int *terminate)
 
 
 
-			nanosleep ((struct timespec[]){{0, intervl}}, NULL);
+			nanosleep ((struct timespec[]){{0, intervl/nsub}}, NULL);
 			
 			// Toggle ledrow off
 			GPIO_CLR = 1 << ledrows[i]; // superstition
@@ -223,6 +275,14 @@ usleep(10);  // waste of cpu cycles but may help against udn2981 ghosting, not f
 
 			switchstatus[i] = switchscan;
 		}
+
+		// publish the three rows together, and only if something changed
+		swbuf = swpub.buf[PANEL_BUF(swpub.seq)];
+		if (memcmp(swbuf, switchstatus, sizeof(switchstatus)) != 0)
+		{	swbuf = panel_next(&swpub.seq, swpub.buf, sizeof(swpub.buf[0]));
+			memcpy(swbuf, switchstatus, sizeof(switchstatus));
+			panel_publish(&swpub.seq);
+		}
 	}
 
 	//printf("\nFP off\n");
@@ -7,6 +7,8 @@
  
 #include <unistd.h>
 #include <fcntl.h> // extra
+#include <stdint.h>
+#include <string.h>
 
  
 //#define BCM2708_PERI_BASE       0x3f000000
@@ -23,4 +25,74 @@ struct bcm2835_peripheral {
 };
  
 //struct bcm2835_peripheral gpio = {GPIO_BASE};
+
+// Incandescent (GLOW) mode: the CPU adds every panel sample to a bit-sliced counter per LED
+// and publishes the counts once per display frame; blink() turns them into brightness levels
+// and PWMs each row over LED_LEVELS sub-frames. Rows 0-3 are packed into word 0 and rows 4-7
+// into word 1, 12 bits per row; plane p holds bit p of the count of every LED.
+#define LED_PLANES	16		// bits per count
+#define LED_LEVELS	8		// brightness levels = PWM sub-frames per frame
+
+typedef struct {
+	uint64_t plane[2][LED_PLANES];	// bit-sliced on-counts
+	uint32_t samples;		// samples in this frame
+} ledacc_t;
+
+// Panel state shared between the CPU thread and blink(). Each kind of state has one writer
+// and is published as a seqlock over two buffers: the writer fills the buffer that is not
+// published, then publishes it with a single store-release of seq + 2, so buffer
+// PANEL_BUF(seq) is always a complete frame. A reader loads seq with acquire order, copies
+// that buffer and retries if seq moved meanwhile, since the writer may then be refilling it.
+// Nobody takes a lock and the writer never waits. seq is always even, so odd values can be
+// used as "never matches" markers.
+#define PANEL_BUF(seq)	(((seq) >> 1) & 1)		// buffer published at seq
+#define PANEL_SEQ(p)	__atomic_load_n(&(p).seq, __ATOMIC_RELAXED)
+
+typedef struct {
+	uint32_t seq;
+	uint32_t buf[2][8];		// ledstatus, written by the CPU
+} ledpub_t;
+
+typedef struct {
+	uint32_t seq;			// also the switch change generation
+	uint32_t buf[2][3];		// switchstatus, written by blink()
+} swpub_t;
+
+typedef struct {
+	uint32_t seq;
+	ledacc_t buf[2];		// GLOW counts, written by the CPU
+} glowpub_t;
+
+// writer: the buffer to fill for the next publish
+static inline void *panel_next(uint32_t *seq, void *buf, size_t size)
+{
+	__atomic_thread_fence(__ATOMIC_RELEASE);	// last publish visible before any refill
+	return (char *)buf + size * PANEL_BUF(*seq + 2);
+}
+
+// writer: publish the buffer returned by panel_next
+static inline void panel_publish(uint32_t *seq)
+{
+	__atomic_store_n(seq, *seq + 2, __ATOMIC_RELEASE);
+}
+
+// reader: copy the published buffer to dst; returns the seq it belongs to
+static inline uint32_t panel_read(uint32_t *seq, const void *buf, size_t size, void *dst)
+{
+	uint32_t s1, s2;
+
+	do {
+		s1 = __atomic_load_n(seq, __ATOMIC_ACQUIRE);
+		memcpy(dst, (const char *)buf + size * PANEL_BUF(s1), size);
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		s2 = __atomic_load_n(seq, __ATOMIC_RELAXED);
+	} while (s1 != s2);
+	return s1;
+}
+
+extern ledpub_t ledpub;
+extern swpub_t swpub;
+extern glowpub_t glowpub;
+extern volatile uint32_t ledreq;	// set by blink() at the start of every display frame
+extern volatile int ledglow;		// GLOW mode on
 #endif
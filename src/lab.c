@@ -0,0 +1,212 @@
+/*
+ * lab.c: run a lab of headless PDP-8s in one process
+ *
+ *	pidp8-lab n script [baseport]
+ *
+ * The simulator keeps all of its state in globals, so the machine state lives in the data
+ * segment of the simulator itself. pidp8-lab carries the simulator as a shared object
+ * (lab/pidp8-core.so, built with the same sources as pidp8) and gives each machine its own
+ * copy of it: the core is written to a memfd per machine and dlopen'ed from there, local to
+ * itself, so every machine has a private data segment - its instance context - and they all
+ * run in one process, one thread each. Machine i runs the core's main() as
+ *
+ *	pidp8 -n -q script baseport+i i
+ *
+ * pinned to cpu i modulo the number of cpus. -n leaves the front panel to the main pidp8.
+ * Base disk images are shared read only with ATTACH -p (see lab.script): their pages are in
+ * memory once, and each machine's writes stay private to it.
+ *
+ * The machines share what a process has only one of: the working directory (so no CD in a
+ * script), the environment, the terminal and signals. stdin is /dev/null, so a machine ends
+ * when its script does, e.g. when the CPU stops on ^E at its console. SIGINT, SIGHUP or
+ * SIGTERM stop all machines, and pidp8-lab exits when the last one has ended. A fatal error
+ * in one machine ends them all.
+ *
+ * www.obsolescenceguaranteed.blogspot.com
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <sched.h>
+#include <pthread.h>
+#include <dlfcn.h>
+#include <sys/mman.h>
+
+#ifndef LAB_CORE
+#define LAB_CORE	"lab/pidp8-core.so"
+#endif
+#define LAB_STACK	(8 << 20)	// stack per machine, as the main thread has
+
+// the core, linked into this binary
+__asm__ (
+	"	.section .rodata\n"
+	"	.balign 64\n"
+	"core_image:\n"
+	"	.incbin \"" LAB_CORE "\"\n"
+	"core_end:\n"
+	"	.previous\n");
+extern const char core_image[], core_end[];
+
+typedef struct {
+	int (*main)(int, char **);
+	volatile int *stop_cpu;		// int32 stop_cpu of this machine
+	char *argv[7];
+	char port[12], num[12];
+	pthread_t thread;
+	volatile int done;
+} machine_t;
+
+static void *run(void *arg)
+{
+	machine_t *m = arg;
+
+	m->main(6, m->argv);
+	__atomic_store_n(&m->done, 1, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+// load a private copy of the core: a memfd is a new file each time, so dlopen maps it anew
+static void *load_core(int i)
+{
+	char name[32], path[32];
+	size_t len = core_end - core_image, off = 0;
+	ssize_t w;
+	void *h;
+	int fd;
+
+	sprintf(name, "pidp8-core%d", i);
+	if ((fd = memfd_create(name, MFD_CLOEXEC)) < 0) {
+		perror("memfd_create");
+		return NULL;
+	}
+	while (off < len) {
+		if ((w = write(fd, core_image + off, len - off)) <= 0) {
+			perror("write core");
+			close(fd);
+			return NULL;
+		}
+		off += w;
+	}
+	// fd stays open: dlopen knows objects by name, so a path reused by the next copy
+	// would hand back this one
+	sprintf(path, "/proc/self/fd/%d", fd);
+	if ((h = dlopen(path, RTLD_NOW | RTLD_LOCAL)) == NULL) {
+		fprintf(stderr, "%s\n", dlerror());
+		close(fd);
+	}
+	return h;
+}
+
+int main(int argc, char *argv[])
+{
+	machine_t *mach;
+	pthread_attr_t attr;
+	cpu_set_t cpus;
+	sigset_t sigs;
+	char *dir, *p;
+	int n, i, sig, ncpu, baseport = 2300, running;
+
+	if (argc < 3 || (n = atoi(argv[1])) <= 0) {
+		fprintf(stderr, "Usage: %s n script [baseport]\n", argv[0]);
+		return 1;
+	}
+	if (argc > 3)
+		baseport = atoi(argv[3]);
+	ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	if (ncpu < 1)
+		ncpu = 1;
+
+	// run where pidp8 would, so that the scripts' relative paths hold
+	if ((dir = realpath("/proc/self/exe", NULL)) != NULL) {
+		if ((p = strrchr(dir, '/')) != NULL)
+			*p = 0;
+		if (chdir(dir))
+			perror(dir);
+		free(dir);
+	}
+	// no machine reads commands from the terminal
+	if (freopen("/dev/null", "r", stdin) == NULL)
+		perror("/dev/null");
+
+	// the machines inherit the mask, so only this thread takes the signals
+	sigemptyset(&sigs);
+	sigaddset(&sigs, SIGINT);
+	sigaddset(&sigs, SIGHUP);
+	sigaddset(&sigs, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &sigs, NULL);
+
+	if ((mach = calloc(n, sizeof(*mach))) == NULL) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, LAB_STACK);
+	for (i = 0; i < n; i++) {
+		machine_t *m = &mach[i];
+		void *h = load_core(i);
+
+		if (h == NULL)
+			break;
+		m->main = (int (*)(int, char **))dlsym(h, "main");
+		m->stop_cpu = dlsym(h, "stop_cpu");
+		if (m->main == NULL || m->stop_cpu == NULL) {
+			fprintf(stderr, "%s: not a simulator core\n", LAB_CORE);
+			break;
+		}
+		sprintf(m->port, "%d", baseport + i);
+		sprintf(m->num, "%d", i);
+		m->argv[0] = "pidp8";
+		m->argv[1] = "-n";
+		m->argv[2] = "-q";
+		m->argv[3] = argv[2];
+		m->argv[4] = m->port;
+		m->argv[5] = m->num;
+		m->argv[6] = NULL;
+		CPU_ZERO(&cpus);
+		CPU_SET(i % ncpu, &cpus);
+		pthread_attr_setaffinity_np(&attr, sizeof(cpus), &cpus);
+		if ((errno = pthread_create(&m->thread, &attr, run, m)) != 0) {
+			perror("pthread_create");
+			m->main = NULL;
+			break;
+		}
+		printf("pidp8-lab %d: telnet port %d\n", i, baseport + i);
+	}
+	n = i;
+
+	// wait for a signal or for all machines to end by themselves
+	for (;;) {
+		struct timespec poll = { 0, 100000000 };
+
+		for (running = i = 0; i < n; i++)
+			running += mach[i].main != NULL && !__atomic_load_n(&mach[i].done, __ATOMIC_ACQUIRE);
+		if (!running)
+			break;
+		sig = sigtimedwait(&sigs, NULL, &poll);
+		if (sig > 0)
+			break;
+	}
+	// stop them: a machine may be between commands and clear stop_cpu as it starts the CPU
+	// again, so keep stopping until each has ended
+	do {
+		struct timespec poll = { 0, 100000000 };
+
+		for (running = i = 0; i < n; i++)
+			if (mach[i].main != NULL && !__atomic_load_n(&mach[i].done, __ATOMIC_ACQUIRE)) {
+				*mach[i].stop_cpu = 1;
+				running++;
+			}
+		if (running)
+			nanosleep(&poll, NULL);
+	} while (running);
+
+	for (i = 0; i < n; i++)
+		if (mach[i].main != NULL)
+			pthread_join(mach[i].thread, NULL);
+	return 0;
+}
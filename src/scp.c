@@ -220,6 +220,7 @@
 #include <unistd.h>	// for sleep()
 
 extern void *blink(void *ptr);	// the real-time multiplexing process to start up
+extern void panel_none(void);	// no panel: publish the switches at rest
 #endif
 
 #define NOT_MUX_USING_CODE /* sim_tmxr library provider or agnostic */
@@ -274,25 +275,55 @@ extern void *blink(void *ptr);	// the real-time multiplexing process to start up
 #define SRBSIZ          1024                            /* save/restore buffer */
 #define SIM_BRK_INILNT  4096                            /* bpt tbl length */
 #define SIM_BRK_ALLTYP  0xFFFFFFFB
+#define SIM_BRK_NTYP    32                              /* types, one per bit */
+#define SIM_BRK_MAPW    24                              /* max addr width mapped */
+#define SIM_BRK_MAPBIT(t,a)     ((sim_brk_map[t][(a) >> 5] >> ((a) & 037)) & 1)
+/* Only the simulation thread updates the times, so no lock is needed */
 #define UPDATE_SIM_TIME                                         \
     if (1) {                                                    \
         int32 _x;                                               \
-        AIO_LOCK;                                               \
-        if (sim_clock_queue == QUEUE_LIST_END)                  \
-            _x = noqueue_time;                                  \
-        else                                                    \
-            _x = sim_clock_queue->time;                         \
-        sim_time = sim_time + (_x - sim_interval);              \
-        sim_rtime = sim_rtime + ((uint32) (_x - sim_interval)); \
-        if (sim_clock_queue == QUEUE_LIST_END)                  \
-            noqueue_time = sim_interval;                        \
-        else                                                    \
-            sim_clock_queue->time = sim_interval;               \
-        AIO_UNLOCK;                                             \
+        _x = sim_qlast - sim_interval;                          \
+        sim_time = sim_time + _x;                               \
+        sim_rtime = sim_rtime + ((uint32) _x);                  \
+        sim_qnow = sim_qnow + _x;                               \
+        sim_qlast = sim_interval;                               \
         }                                                       \
     else                                                        \
         (void)0                                                 \
 
+/* Event queue heap entry.  Entries are ordered by due time, and entries due
+   at the same time in the order they were queued. */
+
+typedef struct {
+    double              due;                            /* event queue due time */
+    t_uint64            seq;                            /* insertion count */
+    UNIT                *uptr;                          /* unit */
+    } QENT;
+
+#define QENT_LT(a,b)    (((a)->due < (b)->due) || \
+                         (((a)->due == (b)->due) && ((a)->seq < (b)->seq)))
+
+/* Event queue statistics, kept per unit while SET QSTATS is in effect.
+   Histogram bucket b counts values in [2^b, 2^(b+1)), bucket 0 also counts
+   0, and the last bucket counts everything above. */
+
+#define QS_NBKT         32                              /* histogram buckets */
+#define QS_LIM(b)       ((double) (((t_uint64) 1) << ((b) + 1)))    /* bucket limit */
+
+struct sim_qstat {
+    UNIT                *uptr;                          /* unit */
+    struct sim_qstat    *next;                          /* next in sim_qstat_list */
+    t_uint64            nact;                           /* activations */
+    t_uint64            ncan;                           /* cancels */
+    t_uint64            nsvc;                           /* service calls */
+    double              svc_ns;                         /* host ns in action */
+    uint32              svc_hist[QS_NBKT];              /* service ns histogram */
+    uint32              dly_hist[QS_NBKT];              /* delay histogram */
+    };
+
+static struct sim_qstat *sim_qstat_get (UNIT *uptr);
+static int32 sim_qbucket (double v);
+
 #define SZ_D(dp) (size_map[((dp)->dwidth + CHAR_BIT - 1) / CHAR_BIT])
 #define SZ_R(rp) \
     (size_map[((rp)->width + (rp)->offset + CHAR_BIT - 1) / CHAR_BIT])
@@ -343,11 +374,14 @@ pthread_t sim_asynch_main_threadid;
 UNIT * volatile sim_asynch_queue;
 UNIT * volatile sim_wallclock_queue;
 UNIT * volatile sim_wallclock_entry;
-UNIT * volatile sim_clock_cosched_queue[SIM_NTIMERS];
+extern UNIT *sim_clock_cosched_queue[SIM_NTIMERS];     /* in sim_timer.c */
 t_bool sim_asynch_enabled = TRUE;
 int32 sim_asynch_check;
 int32 sim_asynch_latency = 4000;      /* 4 usec interrupt latency */
 int32 sim_asynch_inst_latency = 20;   /* assume 5 mip simulator */
+t_uint64 sim_asynch_lat_cnt = 0;      /* events moved to the clock queue */
+t_uint64 sim_asynch_lat_max = 0;      /* and their worst and */
+double sim_asynch_lat_sum = 0;        /* total queued time, nsec */
 #else
 t_bool sim_asynch_enabled = FALSE;
 #endif
@@ -355,7 +389,11 @@ t_bool sim_asynch_enabled = FALSE;
 /* The per-simulator init routine is a weak global that defaults to NULL
    The other per-simulator pointers can be overrriden by the init routine */
 
+#if defined (__GNUC__)
+void (*sim_vm_init) (void) __attribute__ ((weak));
+#else
 void (*sim_vm_init) (void);
+#endif
 char* (*sim_vm_read) (char *ptr, int32 size, FILE *stream) = NULL;
 void (*sim_vm_post) (t_bool from_scp) = NULL;
 CTAB *sim_vm_cmd = NULL;
@@ -364,6 +402,7 @@ t_addr (*sim_vm_parse_addr) (DEVICE *dptr, char *cptr, char **tptr) = NULL;
 t_value (*sim_vm_pc_value) (void) = NULL;
 t_bool (*sim_vm_is_subroutine_call) (t_addr **ret_addrs) = NULL;
 t_bool (*sim_vm_fprint_stopped) (FILE *st, t_stat reason) = NULL;
+void (*sim_vm_attach) (UNIT *uptr, char *cptr) = NULL;
 
 /* Prototypes */
 
@@ -465,6 +504,7 @@ t_stat do_cmd_label (int32 flag, char *cptr, char *label);
 void int_handler (int signal);
 t_stat set_prompt (int32 flag, char *cptr);
 t_stat sim_set_asynch (int32 flag, char *cptr);
+t_stat sim_set_qstats (int32 flag, char *cptr);
 t_stat sim_set_environment (int32 flag, char *cptr);
 static const char *get_dbg_verb (uint32 dbits, DEVICE* dptr);
 
@@ -493,13 +533,22 @@ BRKTAB *sim_brk_tab = NULL;
 int32 sim_brk_ent = 0;
 int32 sim_brk_lnt = 0;
 int32 sim_brk_ins = 0;
+uint32 *sim_brk_map[SIM_BRK_NTYP] = { NULL };
+t_addr sim_brk_maplnt = 0;
 t_bool sim_brk_pend[SIM_BKPT_N_SPC] = { FALSE };
 t_addr sim_brk_ploc[SIM_BKPT_N_SPC] = { 0 };
 int32 sim_quiet = 0;
 int32 sim_step = 0;
 static double sim_time;
 static uint32 sim_rtime;
-static int32 noqueue_time;
+static int32 sim_qlast;                                  /* sim_interval at last update */
+static double sim_qnow;                                 /* event queue time */
+static t_uint64 sim_qseq;                               /* event insertion count */
+static QENT *sim_qheap = NULL;                          /* event heap */
+static int32 sim_qcnt = 0;                              /* entries in heap */
+static int32 sim_qsize = 0;                             /* heap allocation */
+static int32 sim_qstats = 0;                            /* collect statistics */
+static struct sim_qstat *sim_qstat_list = NULL;         /* units with statistics */
 volatile int32 stop_cpu = 0;
 static char **sim_argv;
 t_value *sim_eval = NULL;
@@ -897,9 +946,18 @@ static const char simh_help[] =
       " as paper-tape readers, and devices with write lock switches, such as disks\n"
       " and tapes, support read only operation; other devices do not.  If a file is\n"
       " attached read only, its contents can be examined but not modified.\n"
+      "5-p\n"
+      " If the -p switch is specified, the file is shared read only, and the unit's\n"
+      " writes are kept in memory, private to this simulator, until the unit is\n"
+      " detached; the file itself never changes.  The pages of the file are shared\n"
+      " with every other simulator that attaches it this way, until they are\n"
+      " written.  This is how several machines boot from one system disk image.\n"
+      " It is not available on all hosts, and not for all devices: the unit must\n"
+      " use the standard attach routine.\n"
       "5-q\n"
       " If the -q switch is specified when creating a new file (-n) or opening one\n"
-      " read only (-r), the message announcing this fact is suppressed.\n"
+      " read only (-r) or private (-p), the message announcing this fact is\n"
+      " suppressed.\n"
       "5-f\n"
       " For simulated magnetic tapes, the ATTACH command can specify the format of\n"
       " the attached tape image file:\n\n"
@@ -1056,6 +1114,13 @@ static const char simh_help[] =
       "3Asynch\n"
       "+set asynch                  enable asynchronous I/O\n"
       "+set noasynch                disable asynchronous I/O\n"
+#define HLP_SET_QSTATS "*Commands SET Queue_Statistics"
+      "3Queue Statistics\n"
+      "+set qstats                  clear and collect event queue statistics\n"
+      "+set noqstats                stop collecting event queue statistics\n"
+#define HLP_QBENCH     "*Commands SET Queue_Statistics"
+      "+qbench {n}                  time event queue activate and cancel, up to\n"
+      "++++++++                     n units queued\n"
 #define HLP_SET_ENVIRON "*Commands SET Asynch"
       "3Environment\n"
       "+set environment name=val    set environment variable\n"
@@ -1120,6 +1185,8 @@ static const char simh_help[] =
       "+sh{ow} s{how}               show SHOW commands for all devices\n" 
       "+sh{ow} n{ames}              show logical names\n"
       "+sh{ow} q{ueue}              show event queue\n"
+      "+sh{ow} q{ueue} stats        show event queue statistics (see set qstats)\n"
+      "+sh{ow} q{ueue} csv          show event queue statistics as CSV\n"
       "+sh{ow} ti{me}               show simulated time\n"
       "+sh{ow} th{rottle}           show simulation rate\n"
       "+sh{ow} a{synch}             show asynchronouse I/O state\n" 
@@ -1729,6 +1796,7 @@ static CTAB cmd_table[] = {
     { "LS",         &dir_cmd,       0,          HLP_LS },
     { "SET",        &set_cmd,       0,          HLP_SET },
     { "SHOW",       &show_cmd,      0,          HLP_SHOW },
+    { "QBENCH",     &qbench_cmd,    0,          HLP_QBENCH },
     { "DO",         &do_cmd,        1,          HLP_DO },
     { "GOTO",       &goto_cmd,      1,          HLP_GOTO },
     { "RETURN",     &return_cmd,    0,          HLP_RETURN },
@@ -1767,6 +1835,8 @@ static CTAB set_glob_tab[] = {
     { "NOTHROTTLE", &sim_set_throt,             0, HLP_SET_THROTTLE },
     { "ASYNCH",     &sim_set_asynch,            1, HLP_SET_ASYNCH },
     { "NOASYNCH",   &sim_set_asynch,            0, HLP_SET_ASYNCH },
+    { "QSTATS",     &sim_set_qstats,            1, HLP_SET_QSTATS },
+    { "NOQSTATS",   &sim_set_qstats,            0, HLP_SET_QSTATS },
     { "ENVIRONMENT", &sim_set_environment,      1, HLP_SET_ENVIRON },
     { "ON",         &set_on,                    1, HLP_SET_ON },
     { "NOON",       &set_on,                    0, HLP_SET_ON },
@@ -1888,20 +1958,7 @@ t_stat stat;
 // PiDP8 hack here
  pthread_t thread1;
  const char *message="Thread 1";
- int terminate=0, iret1;
-//	printf("\nPiDP FP driver 3\n");
- 
- // create thread
- iret1 = pthread_create( &thread1, NULL, blink, &terminate);
- 
- if (iret1) {
-   fprintf(stderr, "Error creating thread, return code %d\n", iret1);
-   exit (EXIT_FAILURE);
- }
-//	printf("Created thread, return code %d\n", iret1);
-
- sleep(2);			// allow 2 sec for multiplex to start
-// ------------------------------------------------------------------------
+ int terminate=0, iret1, panel=0;
 #endif
 
 #if defined (__MWERKS__) && defined (macintosh)
@@ -1942,6 +1999,32 @@ for (i = 1; i < argc; i++) {                            /* loop thru args */
 sim_quiet = sim_switches & SWMASK ('Q');                /* -q means quiet */
 sim_on_inherit = sim_switches & SWMASK ('O');           /* -o means inherit on state */
 
+#ifdef PIDP8
+// -n runs without the front panel: no multiplex thread, no GPIO, switches at rest. Only one
+// process can own the panel, so this is how further machines are run on the same Pi, e.g.
+// by pidp8-lab (see lab.c).
+ if (sim_switches & SWMASK ('N')) {
+   sim_switches &= ~SWMASK ('N');
+   panel_none();
+ }
+ else {
+//	printf("\nPiDP FP driver 3\n");
+ 
+ // create thread
+ iret1 = pthread_create( &thread1, NULL, blink, &terminate);
+ 
+ if (iret1) {
+   fprintf(stderr, "Error creating thread, return code %d\n", iret1);
+   exit (EXIT_FAILURE);
+ }
+//	printf("Created thread, return code %d\n", iret1);
+ panel=1;
+
+ sleep(2);			// allow 2 sec for multiplex to start
+ }
+// ------------------------------------------------------------------------
+#endif
+
 sim_init_sock ();                                       /* init socket capabilities */
 AIO_INIT;                                               /* init Asynch I/O */
 if (sim_vm_init != NULL)                                /* call once only */
@@ -1951,7 +2034,8 @@ setenv ("SIM_NAME", sim_name, 1);                       /* Publish simulator nam
 stop_cpu = 0;
 sim_interval = 0;
 sim_time = sim_rtime = 0;
-noqueue_time = 0;
+sim_qlast = 0;
+sim_qnow = 0;
 sim_clock_queue = QUEUE_LIST_END;
 sim_is_running = 0;
 sim_log = NULL;
@@ -2036,7 +2120,7 @@ free (targv);                                           /* release any argv copy
 
 #ifdef PIDP8
  terminate=1;
- if (pthread_join(thread1, NULL))
+ if (panel && pthread_join(thread1, NULL))
    printf("\r\nError joining multiplex thread\r\n");
 #endif
 
@@ -3790,6 +3874,12 @@ fprintf (st, "Asynchronous Multiplexer support is available\n");
 #if defined(SIM_ASYNCH_CLOCKS)
 fprintf (st, "Asynchronous Clock is %sabled\n", (sim_asynch_timer) ? "en" : "dis");
 #endif
+fprintf (st, "Interrupt latency: %d nanoseconds, %d instructions\n",
+    sim_asynch_latency, sim_asynch_inst_latency);
+if (sim_asynch_lat_cnt)
+    fprintf (st, "Completion latency: %.0f events, mean %.0f, max %.0f nanoseconds\n",
+        (double) sim_asynch_lat_cnt, sim_asynch_lat_sum / sim_asynch_lat_cnt,
+        (double) sim_asynch_lat_max);
 #else
 fprintf (st, "Asynchronous I/O is not available in this simulator\n");
 #endif
@@ -4462,22 +4552,48 @@ else if (!flag)
 return SCPE_OK;
 }
 
+static t_stat sim_show_qstats (FILE *st, t_bool csv);
+
+static int sim_qent_compare (const void *pa, const void *pb)
+{
+const QENT *a = (const QENT *) pa, *b = (const QENT *) pb;
+
+return QENT_LT (a, b)? -1: (QENT_LT (b, a)? 1: 0);
+}
+
 t_stat show_queue (FILE *st, DEVICE *dnotused, UNIT *unotused, int32 flag, char *cptr)
 {
 DEVICE *dptr;
 UNIT *uptr;
-int32 accum;
+QENT *qptr;
+int32 i;
 
-if (cptr && (*cptr != 0))
-    return SCPE_2MARG;
+if (cptr && (*cptr != 0)) {
+    char gbuf[CBUFSIZE];
+
+    cptr = get_glyph (cptr, gbuf, 0);
+    if (*cptr != 0)
+        return SCPE_2MARG;
+    if (MATCH_CMD (gbuf, "STATS") == 0)
+        return sim_show_qstats (st, FALSE);
+    if (MATCH_CMD (gbuf, "CSV") == 0)
+        return sim_show_qstats (st, TRUE);
+    return SCPE_ARG;
+    }
 if (sim_clock_queue == QUEUE_LIST_END)
     fprintf (st, "%s event queue empty, time = %.0f, executing %.0f instructios/sec\n",
              sim_name, sim_time, sim_timer_inst_per_sec ());
 else {
     fprintf (st, "%s event queue status, time = %.0f, executing %.0f instructions/sec\n",
              sim_name, sim_time, sim_timer_inst_per_sec ());
-    accum = 0;
-    for (uptr = sim_clock_queue; uptr != QUEUE_LIST_END; uptr = uptr->next) {
+    UPDATE_SIM_TIME;
+    qptr = (QENT *) malloc (sim_qcnt * sizeof (*qptr));
+    if (qptr == NULL)
+        return SCPE_MEM;
+    memcpy (qptr, sim_qheap, sim_qcnt * sizeof (*qptr));
+    qsort (qptr, sim_qcnt, sizeof (*qptr), sim_qent_compare);
+    for (i = 0; i < sim_qcnt; i++) {
+        uptr = qptr[i].uptr;
         if (uptr == &sim_step_unit)
             fprintf (st, "  Step timer");
         else
@@ -4491,9 +4607,9 @@ else {
                     }
                 else
                     fprintf (st, "  Unknown");
-        fprintf (st, " at %d\n", accum + uptr->time);
-        accum = accum + uptr->time;
+        fprintf (st, " at %d\n", (int32) (qptr[i].due - sim_qnow));
         }
+    free (qptr);
     }
 sim_show_clock_queues (st, dnotused, unotused, flag, cptr);
 #if defined (SIM_ASYNCH_IO)
@@ -5159,13 +5275,19 @@ sim_trim_endspc (cptr);                                 /* trim trailing spc */
 return scp_attach_unit (dptr, uptr, cptr);              /* attach */
 }
 
-/* Call device-specific or file-oriented attach unit routine */
+/* Call device-specific or file-oriented attach unit routine.  A successful
+   attach is reported to the simulator, if it asked (sim_vm_attach). */
 
 t_stat scp_attach_unit (DEVICE *dptr, UNIT *uptr, char *cptr)
 {
+t_stat r;
+
 if (dptr->attach != NULL)                               /* device routine? */
-    return dptr->attach (uptr, cptr);                   /* call it */
-return attach_unit (uptr, cptr);                        /* no, std routine */
+    r = dptr->attach (uptr, cptr);                      /* call it */
+else r = attach_unit (uptr, cptr);                      /* no, std routine */
+if ((r == SCPE_OK) && (sim_vm_attach != NULL))          /* tell the VM */
+    sim_vm_attach (uptr, cptr);
+return r;
 }
 
 /* Attach unit to file */
@@ -5184,7 +5306,15 @@ uptr->filename = (char *) calloc (CBUFSIZE, sizeof (char)); /* alloc name buf */
 if (uptr->filename == NULL)
     return SCPE_MEM;
 strncpy (uptr->filename, cptr, CBUFSIZE);               /* save name */
-if (sim_switches & SWMASK ('R')) {                      /* read only? */
+if (sim_switches & SWMASK ('P')) {                      /* private writes? */
+    uptr->fileref = sim_fopen_private (cptr, ((t_offset) uptr->capac) * SZ_D (dptr));
+    if (uptr->fileref == NULL)                          /* open fail? */
+        return attach_err (uptr, SCPE_OPENERR);         /* yes, error */
+    if (!sim_quiet && !(sim_switches & SWMASK ('Q'))) {
+        sim_printf ("%s: unit is shared, writes are private\n", sim_dname (dptr));
+        }
+    }
+else if (sim_switches & SWMASK ('R')) {                 /* read only? */
     if ((uptr->flags & UNIT_ROABLE) == 0)               /* allowed? */
         return attach_err (uptr, SCPE_NORO);            /* no, error */
     uptr->fileref = sim_fopen (cptr, "rb");             /* open rd only */
@@ -5331,9 +5461,14 @@ return SCPE_OK;
 
 t_stat scp_detach_unit (DEVICE *dptr, UNIT *uptr)
 {
+t_stat r;
+
 if (dptr->detach != NULL)                               /* device routine? */
-    return dptr->detach (uptr);
-return detach_unit (uptr);                              /* no, standard */
+    r = dptr->detach (uptr);
+else r = detach_unit (uptr);                            /* no, standard */
+if ((r == SCPE_OK) && (sim_vm_attach != NULL))          /* tell the VM */
+    sim_vm_attach (uptr, NULL);
+return r;
 }
 
 /* Detach unit from file */
@@ -6202,15 +6337,16 @@ if (sim_deb && (sim_deb != stdout) && (sim_deb != sim_log))/* debug if enabled *
 
 t_stat sim_run_boot_prep (void)
 {
-UNIT *uptr;
+int32 i;
 
 sim_interval = 0;                                       /* reset queue */
 sim_time = sim_rtime = 0;
-noqueue_time = 0;
-for (uptr = sim_clock_queue; uptr != QUEUE_LIST_END; uptr = sim_clock_queue) {
-    sim_clock_queue = uptr->next;
-    uptr->next = NULL;
-    }
+sim_qlast = 0;
+sim_qnow = 0;
+for (i = 0; i < sim_qcnt; i++)
+    sim_qheap[i].uptr->next = NULL;
+sim_qcnt = 0;
+sim_clock_queue = QUEUE_LIST_END;
 return reset_all (0);
 }
 
@@ -8308,8 +8444,80 @@ return SCPE_OK;
    and to see if further events need to be processed, or sim_interval
    reset to count the next one.
 
-   The event queue is maintained in clock order; entry timeouts are
-   RELATIVE to the time in the previous entry.
+   The event queue is an indexed binary heap, ordered by due time in
+   event queue time, and for equal due times by order of queueing.  Event
+   queue time advances with sim_interval, except that it is held at the
+   due time of the event being processed, so that an instruction which
+   overruns sim_interval does not shorten the following events.  The
+   entry at the top of the heap is sim_clock_queue, and sim_interval
+   counts down to it.  A queued unit has a non-NULL next (QUEUE_LIST_END)
+   and its heap slot in qindex, so activation and cancel are O(log n).
+
+   sim_qup, sim_qdown - restore heap order from a slot
+   sim_qremove - remove the entry in a slot
+   sim_qsched - reset sim_clock_queue and sim_interval from the heap
+*/
+
+static void sim_qup (int32 i)
+{
+QENT ent = sim_qheap[i];
+int32 p;
+
+while (i > 0) {
+    p = (i - 1) >> 1;
+    if (!QENT_LT (&ent, &sim_qheap[p]))
+        break;
+    sim_qheap[i] = sim_qheap[p];
+    sim_qheap[i].uptr->qindex = i;
+    i = p;
+    }
+sim_qheap[i] = ent;
+ent.uptr->qindex = i;
+}
+
+static void sim_qdown (int32 i)
+{
+QENT ent = sim_qheap[i];
+int32 c;
+
+while ((c = (2 * i) + 1) < sim_qcnt) {
+    if (((c + 1) < sim_qcnt) && QENT_LT (&sim_qheap[c + 1], &sim_qheap[c]))
+        c = c + 1;
+    if (!QENT_LT (&sim_qheap[c], &ent))
+        break;
+    sim_qheap[i] = sim_qheap[c];
+    sim_qheap[i].uptr->qindex = i;
+    i = c;
+    }
+sim_qheap[i] = ent;
+ent.uptr->qindex = i;
+}
+
+static void sim_qremove (int32 i)
+{
+sim_qheap[i].uptr->next = NULL;
+sim_qheap[i].uptr->time = 0;
+sim_qcnt = sim_qcnt - 1;
+if (i < sim_qcnt) {                                     /* fill hole from end */
+    sim_qheap[i] = sim_qheap[sim_qcnt];
+    sim_qdown (i);
+    sim_qup (i);
+    }
+}
+
+static void sim_qsched (void)
+{
+if (sim_qcnt == 0) {
+    sim_clock_queue = QUEUE_LIST_END;
+    sim_interval = sim_qlast = NOQUEUE_WAIT;
+    }
+else {
+    sim_clock_queue = sim_qheap[0].uptr;
+    sim_interval = sim_qlast = (int32) (sim_qheap[0].due - sim_qnow);
+    }
+}
+
+/*
 
    sim_process_event - process event
 
@@ -8331,22 +8539,32 @@ AIO_UPDATE_QUEUE;
 UPDATE_SIM_TIME;                                        /* update sim time */
 
 if (sim_clock_queue == QUEUE_LIST_END) {                /* queue empty? */
-    sim_interval = noqueue_time = NOQUEUE_WAIT;         /* flag queue empty */
+    sim_interval = sim_qlast = NOQUEUE_WAIT;            /* flag queue empty */
     sim_debug (SIM_DBG_EVENT, sim_dflt_dev, "Queue Empty New Interval = %d\n", sim_interval);
     return SCPE_OK;
     }
 do {
     uptr = sim_clock_queue;                             /* get first */
-    sim_clock_queue = uptr->next;                       /* remove first */
-    uptr->next = NULL;                                  /* hygiene */
-    uptr->time = 0;
-    if (sim_clock_queue != QUEUE_LIST_END)
-        sim_interval = sim_clock_queue->time;
-    else
-        sim_interval = noqueue_time = NOQUEUE_WAIT;
+    sim_qnow = sim_qheap[0].due;                        /* queue time is its due time */
+    sim_qremove (0);                                    /* remove first */
+    sim_qsched ();
     sim_debug (SIM_DBG_EVENT, sim_dflt_dev, "Processing Event for %s\n", sim_uname (uptr));
     AIO_EVENT_BEGIN(uptr);
-    if (uptr->action != NULL)
+    if (sim_qstats) {                                   /* time the action */
+        struct sim_qstat *qs = sim_qstat_get (uptr);
+        t_uint64 t0;
+        double ns;
+
+        t0 = sim_os_nsec ();                            /* monotonic */
+        reason = (uptr->action != NULL)? uptr->action (uptr): SCPE_OK;
+        ns = (double) (sim_os_nsec () - t0);
+        if (qs != NULL) {
+            qs->nsvc = qs->nsvc + 1;
+            qs->svc_ns = qs->svc_ns + ns;
+            qs->svc_hist[sim_qbucket (ns)]++;
+            }
+        }
+    else if (uptr->action != NULL)
         reason = uptr->action (uptr);
     else
         reason = SCPE_OK;
@@ -8357,7 +8575,6 @@ do {
              (!stop_cpu));
 
 if (sim_clock_queue == QUEUE_LIST_END) {                /* queue empty? */
-    sim_interval = noqueue_time = NOQUEUE_WAIT;         /* flag queue empty */
     sim_debug (SIM_DBG_EVENT, sim_dflt_dev, "Processing Queue Complete New Interval = %d\n", sim_interval);
     }
 else
@@ -8384,8 +8601,7 @@ return _sim_activate (uptr, event_time);
 
 t_stat _sim_activate (UNIT *uptr, int32 event_time)
 {
-UNIT *cptr, *prvptr;
-int32 accum;
+QENT *qptr;
 
 AIO_ACTIVATE (_sim_activate, uptr, event_time);
 if (sim_is_active (uptr))                               /* already active? */
@@ -8394,26 +8610,30 @@ UPDATE_SIM_TIME;                                        /* update sim time */
 
 sim_debug (SIM_DBG_ACTIVATE, sim_dflt_dev, "Activating %s delay=%d\n", sim_uname (uptr), event_time);
 
-prvptr = NULL;
-accum = 0;
-for (cptr = sim_clock_queue; cptr != QUEUE_LIST_END; cptr = cptr->next) {
-    if (event_time < (accum + cptr->time))
-        break;
-    accum = accum + cptr->time;
-    prvptr = cptr;
-    }
-if (prvptr == NULL) {                                   /* insert at head */
-    cptr = uptr->next = sim_clock_queue;
-    sim_clock_queue = uptr;
-    }
-else {
-    cptr = uptr->next = prvptr->next;                   /* insert at prvptr */
-    prvptr->next = uptr;
-    }
-uptr->time = event_time - accum;
-if (cptr != QUEUE_LIST_END)
-    cptr->time = cptr->time - uptr->time;
-sim_interval = sim_clock_queue->time;
+if (sim_qcnt >= sim_qsize) {                           /* grow heap */
+    qptr = (QENT *) realloc (sim_qheap, (sim_qsize + 64) * 2 * sizeof (*qptr));
+    if (qptr == NULL)
+        return SCPE_MEM;
+    sim_qheap = qptr;
+    sim_qsize = (sim_qsize + 64) * 2;
+    }
+if (sim_qstats) {
+    struct sim_qstat *qs = sim_qstat_get (uptr);
+
+    if (qs != NULL) {
+        qs->nact = qs->nact + 1;
+        qs->dly_hist[sim_qbucket (event_time)]++;
+        }
+    }
+qptr = &sim_qheap[sim_qcnt];
+qptr->due = sim_qnow + event_time;
+qptr->seq = sim_qseq++;
+qptr->uptr = uptr;
+uptr->next = QUEUE_LIST_END;                            /* mark active */
+uptr->time = event_time;
+sim_qcnt = sim_qcnt + 1;
+sim_qup (sim_qcnt - 1);
+sim_qsched ();
 return SCPE_OK;
 }
 
@@ -8490,8 +8710,6 @@ return sim_timer_activate_after (uptr, usec_delay);
 
 t_stat sim_cancel (UNIT *uptr)
 {
-UNIT *cptr, *nptr;
-
 AIO_VALIDATE;
 AIO_CANCEL(uptr);
 AIO_UPDATE_QUEUE;
@@ -8499,37 +8717,23 @@ if (sim_clock_queue == QUEUE_LIST_END)
     return SCPE_OK;
 sim_debug (SIM_DBG_EVENT, sim_dflt_dev, "Canceling Event for %s\n", sim_uname(uptr));
 UPDATE_SIM_TIME;                                        /* update sim time */
-if (!sim_is_active (uptr))
+if (uptr->next == NULL)
     return SCPE_OK;
-nptr = QUEUE_LIST_END;
-
-if (sim_clock_queue == uptr) {
-    nptr = sim_clock_queue = uptr->next;
-    uptr->next = NULL;                                  /* hygiene */
-    }
-else {
-    for (cptr = sim_clock_queue; cptr != QUEUE_LIST_END; cptr = cptr->next) {
-        if (cptr->next == uptr) {
-            nptr = cptr->next = uptr->next;
-            uptr->next = NULL;                          /* hygiene */
-            break;                                      /* end queue scan */
-            }
-        }
-    }
-if (nptr != QUEUE_LIST_END)
-    nptr->time += (uptr->next) ? 0 : uptr->time;
-if (!uptr->next)
-    uptr->time = 0;
-if (sim_clock_queue != QUEUE_LIST_END)
-    sim_interval = sim_clock_queue->time;
-else sim_interval = noqueue_time = NOQUEUE_WAIT;
-if (uptr->next) {
+if ((uptr->qindex >= sim_qcnt) || (sim_qheap[uptr->qindex].uptr != uptr)) {
     if (sim_deb) {
         sim_debug (SIM_DBG_EVENT, sim_dflt_dev, "Cancel failed for %s\n", sim_uname(uptr));
         fclose(sim_deb);
         }
     abort ();
     }
+if (sim_qstats) {
+    struct sim_qstat *qs = sim_qstat_get (uptr);
+
+    if (qs != NULL)
+        qs->ncan = qs->ncan + 1;
+    }
+sim_qremove (uptr->qindex);
+sim_qsched ();
 return SCPE_OK;
 }
 
@@ -8558,21 +8762,17 @@ return (((uptr->next) || AIO_IS_ACTIVE(uptr)) ? TRUE : FALSE);
 
 int32 sim_activate_time (UNIT *uptr)
 {
-UNIT *cptr;
-int32 accum = 0;
+double now;
 
 AIO_VALIDATE;
 AIO_RETURN_TIME(uptr);
-for (cptr = sim_clock_queue; cptr != QUEUE_LIST_END; cptr = cptr->next) {
-    if (cptr == sim_clock_queue) {
-        if (sim_interval > 0)
-            accum = accum + sim_interval;
-        }
-    else accum = accum + cptr->time;
-    if (cptr == uptr)
-        return accum + 1;
-    }
-return 0;
+if (uptr->next == NULL)
+    return 0;
+UPDATE_SIM_TIME;
+now = sim_qnow;                                         /* count an overrun as 0 */
+if (now > sim_qheap[0].due)
+    now = sim_qheap[0].due;
+return (int32) (sim_qheap[uptr->qindex].due - now) + 1;
 }
 
 /* sim_gtime - return global time
@@ -8606,13 +8806,208 @@ return sim_rtime;
 
 int32 sim_qcount (void)
 {
-int32 cnt;
-UNIT *uptr;
+return sim_qcnt;
+}
+
+/* qbench_cmd - time event queue activation and cancel
+
+   Queues n dummy units at random delays, for n = 0, 1, 2, 4 ... up to the
+   argument (default 4096), and at each size times activating, then
+   canceling, batches of QB_BATCH more units on top of them.  The queue,
+   including the simulator's own events, is left as it was.
+*/
+
+#define QB_BATCH        64                              /* units per timed batch */
+#define QB_NSEC         100000000.0                     /* time per size, ns */
+
+t_stat qbench_cmd (int32 flag, char *cptr)
+{
+UNIT *units;
+t_uint64 t0;
+double ns_act, ns_can;
+uint32 seed = 1;
+int32 max = 4096, n, i, cnt, qstats = sim_qstats;
+t_stat r;
+
+if (*cptr) {
+    max = (int32) get_uint (cptr, 10, 1000000, &r);
+    if (r != SCPE_OK)
+        return SCPE_ARG;
+    }
+units = (UNIT *) calloc (max + QB_BATCH, sizeof (*units));
+if (units == NULL)
+    return SCPE_MEM;
+sim_qstats = 0;                                         /* dummies are not counted */
+sim_printf ("   queued   activate     cancel\n");
+for (n = 0; n <= max; n = (n == 0)? 1: n * 2) {
+    for (i = 0; i < n; i++) {                           /* background load */
+        seed = (seed * 1103515245) + 12345;
+        sim_activate (&units[i], 1 + (int32) ((seed >> 8) % 1000000));
+        }
+    ns_act = ns_can = 0.0;
+    cnt = 0;
+    do {
+        t0 = sim_os_nsec ();                            /* monotonic */
+        for (i = n; i < n + QB_BATCH; i++) {
+            seed = (seed * 1103515245) + 12345;
+            sim_activate (&units[i], 1 + (int32) ((seed >> 8) % 1000000));
+            }
+        ns_act = ns_act + (double) (sim_os_nsec () - t0);
+        t0 = sim_os_nsec ();
+        for (i = n; i < n + QB_BATCH; i++)
+            sim_cancel (&units[i]);
+        ns_can = ns_can + (double) (sim_os_nsec () - t0);
+        cnt = cnt + QB_BATCH;
+        } while ((ns_act + ns_can) < QB_NSEC);
+    for (i = 0; i < n; i++)
+        sim_cancel (&units[i]);
+    sim_printf ("%9d %8.1f ns %8.1f ns\n", n, ns_act / cnt, ns_can / cnt);
+    }
+free (units);
+sim_qstats = qstats;
+return SCPE_OK;
+}
+
+/* Event queue statistics
+
+   sim_qstat_get - find or create the statistics of a unit
+   sim_qbucket - histogram bucket of a value
+   sim_set_qstats - SET QSTATS (clear and start) and SET NOQSTATS (stop)
+   sim_show_qstats - SHOW QUEUE STATS and SHOW QUEUE CSV
+
+   The statistics hang off the unit, so that counting costs a pointer test
+   while they are collected and one flag test while they are not.
+*/
+
+static struct sim_qstat *sim_qstat_get (UNIT *uptr)
+{
+struct sim_qstat *qs = uptr->qstat;
+
+if (qs == NULL) {
+    qs = (struct sim_qstat *) calloc (1, sizeof (*qs));
+    if (qs == NULL)
+        return NULL;
+    qs->uptr = uptr;
+    qs->next = sim_qstat_list;
+    sim_qstat_list = uptr->qstat = qs;
+    }
+return qs;
+}
+
+static int32 sim_qbucket (double v)
+{
+int32 b = 0;
+
+while ((v >= 2.0) && (b < (QS_NBKT - 1))) {
+    v = v / 2.0;
+    b = b + 1;
+    }
+return b;
+}
+
+t_stat sim_set_qstats (int32 flag, char *cptr)
+{
+struct sim_qstat *qs;
+
+if (cptr && (*cptr != 0))
+    return SCPE_2MARG;
+if (flag) {                                             /* clear on start */
+    for (qs = sim_qstat_list; qs != NULL; qs = qs->next) {
+        UNIT *uptr = qs->uptr;
+        struct sim_qstat *nxt = qs->next;
+
+        memset (qs, 0, sizeof (*qs));
+        qs->uptr = uptr;
+        qs->next = nxt;
+        }
+    }
+sim_qstats = flag;
+return SCPE_OK;
+}
+
+static int sim_qstat_compare (const void *pa, const void *pb)
+{
+const struct sim_qstat *a = *(const struct sim_qstat * const *) pa;
+const struct sim_qstat *b = *(const struct sim_qstat * const *) pb;
+
+return (a->svc_ns > b->svc_ns)? -1: ((a->svc_ns < b->svc_ns)? 1: 0);
+}
+
+/* Upper limit of the histogram bucket holding fraction frac of the counts */
+
+static double sim_qstat_pct (const uint32 *hist, double frac)
+{
+double tot = 0.0, cum = 0.0;
+int32 b;
+
+for (b = 0; b < QS_NBKT; b++)
+    tot = tot + hist[b];
+for (b = 0; b < QS_NBKT; b++) {
+    cum = cum + hist[b];
+    if ((tot > 0.0) && (cum >= (frac * tot)))
+        break;
+    }
+return (b < QS_NBKT)? QS_LIM (b): 0.0;
+}
+
+static const char *sim_qstat_name (UNIT *uptr)
+{
+const char *nm;
+
+if (uptr == &sim_step_unit)
+    return "STEP";
+if (uptr == &sim_expect_unit)
+    return "EXPECT";
+nm = sim_uname (uptr);
+return (*nm != 0)? nm: "UNKNOWN";
+}
+
+static t_stat sim_show_qstats (FILE *st, t_bool csv)
+{
+struct sim_qstat *qs, **tab;
+int32 i, b, n = 0;
 
-cnt = 0;
-for (uptr = sim_clock_queue; uptr != QUEUE_LIST_END; uptr = uptr->next)
-    cnt++;
-return cnt;
+for (qs = sim_qstat_list; qs != NULL; qs = qs->next)
+    n = n + 1;
+tab = (struct sim_qstat **) malloc ((n + 1) * sizeof (*tab));
+if (tab == NULL)
+    return SCPE_MEM;
+for (qs = sim_qstat_list, i = 0; qs != NULL; qs = qs->next)
+    tab[i++] = qs;
+qsort (tab, n, sizeof (*tab), sim_qstat_compare);       /* busiest first */
+if (csv) {
+    fprintf (st, "unit,activations,cancels,services,service_ns");
+    for (b = 0; b < QS_NBKT; b++)
+        fprintf (st, ",svc_lt_%.0f", QS_LIM (b));
+    for (b = 0; b < QS_NBKT; b++)
+        fprintf (st, ",delay_lt_%.0f", QS_LIM (b));
+    fprintf (st, "\n");
+    for (i = 0; i < n; i++) {
+        qs = tab[i];
+        fprintf (st, "%s,%" LL_FMT "u,%" LL_FMT "u,%" LL_FMT "u,%.0f", sim_qstat_name (qs->uptr),
+                 qs->nact, qs->ncan, qs->nsvc, qs->svc_ns);
+        for (b = 0; b < QS_NBKT; b++)
+            fprintf (st, ",%u", qs->svc_hist[b]);
+        for (b = 0; b < QS_NBKT; b++)
+            fprintf (st, ",%u", qs->dly_hist[b]);
+        fprintf (st, "\n");
+        }
+    }
+else {
+    fprintf (st, "Event queue statistics%s, busiest first\n",
+             sim_qstats? "": " (not collecting)");
+    fprintf (st, "%-10s %10s %10s %10s %10s %8s %8s %8s %10s\n", "unit", "activate", "cancel",
+             "service", "svc ms", "mean ns", "p50 ns<", "p99 ns<", "p50 delay<");
+    for (i = 0; i < n; i++) {
+        qs = tab[i];
+        fprintf (st, "%-10s %10" LL_FMT "u %10" LL_FMT "u %10" LL_FMT "u %10.1f %8.0f %8.0f %8.0f %10.0f\n",
+                 sim_qstat_name (qs->uptr), qs->nact, qs->ncan, qs->nsvc, qs->svc_ns / 1000000.0,
+                 qs->nsvc? qs->svc_ns / qs->nsvc: 0.0, sim_qstat_pct (qs->svc_hist, 0.5),
+                 sim_qstat_pct (qs->svc_hist, 0.99), sim_qstat_pct (qs->dly_hist, 0.5));
+        }
+    }
+free (tab);
+return SCPE_OK;
 }
 
 /* Breakpoint package.  This module replaces the VM-implemented one
@@ -8632,6 +9027,12 @@ return cnt;
    is the bitwise OR of all the type fields).  A simulator need only check for
    a breakpoint of type X if bit SWMASK('X') is set in sim_brk_sum.
 
+   For the addresses of the default device, up to SIM_BRK_MAPW bits wide,
+   each type also has a bitmap, one bit per address, created when the first
+   breakpoint of the type is set.  sim_brk_test checks the maps first, so an
+   address with no breakpoint is rejected with a bit test rather than a
+   search of the table; the table still holds counts and actions.
+
    The package contains the following public routines:
 
         sim_brk_init            initialize
@@ -8660,6 +9061,35 @@ sim_brk_npc (0);
 return SCPE_OK;
 }
 
+/* Update the breakpoint maps for the types sw at loc.  A type's map is only
+   created while it has no breakpoints, so that it holds all of them. */
+
+static void sim_brk_mapset (t_addr loc, uint32 sw, t_bool set)
+{
+uint32 t;
+
+if ((sim_brk_maplnt == 0) && sim_dflt_dev &&            /* size maps once */
+    (sim_dflt_dev->awidth <= SIM_BRK_MAPW))
+    sim_brk_maplnt = ((t_addr) 1) << sim_dflt_dev->awidth;
+if (loc >= sim_brk_maplnt)                              /* not mapped? */
+    return;
+for (t = 0; t < SIM_BRK_NTYP; t++) {
+    if (((sw >> t) & 1) == 0)
+        continue;
+    if (sim_brk_map[t] == NULL) {
+        if (!set || (sim_brk_summ & (1u << t)))         /* nothing to do, or */
+            continue;                                   /* too late to map */
+        sim_brk_map[t] = (uint32 *) calloc ((size_t) ((sim_brk_maplnt + 31) >> 5), sizeof (uint32));
+        if (sim_brk_map[t] == NULL)                     /* no map, search */
+            continue;
+        }
+    if (set)
+        sim_brk_map[t][loc >> 5] |= (1u << (loc & 037));
+    else sim_brk_map[t][loc >> 5] &= ~(1u << (loc & 037));
+    }
+return;
+}
+
 /* Search for a breakpoint in the sorted breakpoint table */
 
 BRKTAB *sim_brk_fnd (t_addr loc)
@@ -8738,6 +9168,7 @@ if (!bp)                                                /* no, allocate */
     bp = sim_brk_new (loc);
 if (!bp)                                                /* still no? mem err */
     return SCPE_MEM;
+sim_brk_mapset (loc, sw, TRUE);                         /* before summ */
 bp->typ |= sw;                                          /* set type */
 bp->cnt = ncnt;                                         /* set count */
 if ((!(sw & BRK_TYP_DYN_ALL)) &&                        /* Not Dynamic and */
@@ -8766,6 +9197,7 @@ if (!bp)                                                /* not there? ok */
     return SCPE_OK;
 if (sw == 0)
     sw = SIM_BRK_ALLTYP;
+sim_brk_mapset (loc, bp->typ & sw, FALSE);
 bp->typ = bp->typ & ~sw;
 if (bp->typ)                                            /* clear all types? */
     return SCPE_OK;
@@ -8869,6 +9301,19 @@ uint32 spc = (btyp >> SIM_BKPT_V_SPC) & (SIM_BKPT_N_SPC - 1);
 if (sim_brk_summ & BRK_TYP_DYN_ALL)
     btyp |= BRK_TYP_DYN_ALL;
 
+if (loc < sim_brk_maplnt) {                             /* mapped address? */
+    uint32 t, m = btyp & sim_brk_summ;
+
+    for (t = 0; m != 0; m = m >> 1, t++) {              /* each type to test */
+        if ((m & 1) && ((sim_brk_map[t] == NULL) ||     /* unmapped or set? */
+            SIM_BRK_MAPBIT (t, loc)))
+            break;                                      /* search */
+        }
+    if (m == 0) {                                       /* none here */
+        sim_brk_pend[spc] = FALSE;
+        return 0;
+        }
+    }
 if ((bp = sim_brk_fnd (loc)) && (btyp & bp->typ)) {     /* in table, and type match? */
     if ((sim_brk_pend[spc] && (loc == sim_brk_ploc[spc])) || /* previous location? */
         (--bp->cnt > 0))                                /* count > 0? */
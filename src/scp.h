@@ -100,6 +100,7 @@ t_stat help_cmd (int32 flag, char *ptr);
 t_stat screenshot_cmd (int32 flag, char *ptr);
 t_stat spawn_cmd (int32 flag, char *ptr);
 t_stat echo_cmd (int32 flag, char *ptr);
+t_stat qbench_cmd (int32 flag, char *ptr);
 
 /* Utility routines */
 
@@ -269,6 +270,7 @@ extern CTAB *sim_vm_cmd;
 extern void (*sim_vm_fprint_addr) (FILE *st, DEVICE *dptr, t_addr addr);
 extern t_addr (*sim_vm_parse_addr) (DEVICE *dptr, char *cptr, char **tptr);
 extern t_bool (*sim_vm_fprint_stopped) (FILE *st, t_stat reason);
+extern void (*sim_vm_attach) (UNIT *uptr, char *cptr);
 extern t_value (*sim_vm_pc_value) (void);
 extern t_bool (*sim_vm_is_subroutine_call) (t_addr **ret_addrs);
 
@@ -2186,7 +2186,8 @@ if (!sim_con_tmxr.ldsc->uptr) {                         /* If simulator didn't d
     }
 else {
 #if defined(SIM_ASYNCH_IO) && defined(SIM_ASYNCH_MUX)
-    if (sim_asynch_enabled) {
+    if (sim_asynch_enabled &&                           /* unless the simulator wants it */
+        !(sim_con_tmxr.ldsc->uptr->dynflags & TMUF_NOASYNCH)) { /* polled on its clock */
         sim_con_tmxr.ldsc->uptr->dynflags |= UNIT_TM_POLL;/* flag console input device as a polling unit */
         sim_con_unit.dynflags |= UNIT_TM_POLL;         /* flag as polling unit */
         }
@@ -2194,7 +2195,7 @@ else {
     }
 #if defined(SIM_ASYNCH_IO) && defined(SIM_ASYNCH_MUX)
 pthread_mutex_lock (&sim_tmxr_poll_lock);
-if (sim_asynch_enabled) {
+if (sim_asynch_enabled && (sim_con_unit.dynflags & UNIT_TM_POLL)) {
     pthread_attr_t attr;
 
     pthread_cond_init (&sim_console_startup_cond, NULL);
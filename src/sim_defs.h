@@ -485,6 +485,8 @@ struct sim_unit {
     int32               u6;                             /* device specific */
     void                *up7;                           /* device specific */
     void                *up8;                           /* device specific */
+    int32               qindex;                         /* event heap slot */
+    struct sim_qstat    *qstat;                         /* event queue statistics */
 #ifdef SIM_ASYNCH_IO
     void                (*a_check_completion)(struct sim_unit *);
     t_bool              (*a_is_active)(struct sim_unit *);
@@ -502,6 +504,7 @@ struct sim_unit {
     double              a_skew;                         /* accumulated skew being corrected */
     double              a_last_fired_time;              /* time last event fired */
     int32               a_usec_delay;                   /* time delay for timer event */
+    t_uint64            a_queue_ns;                     /* host time queued, ns */
 #endif
     };
 
@@ -871,6 +874,9 @@ extern volatile t_bool sim_idle_wait;
 extern int32 sim_asynch_check;
 extern int32 sim_asynch_latency;
 extern int32 sim_asynch_inst_latency;
+extern t_uint64 sim_asynch_lat_cnt;
+extern t_uint64 sim_asynch_lat_max;
+extern double sim_asynch_lat_sum;
 
 /* Thread local storage */
 #if defined(__GNUC__) && !defined(__APPLE__) && !defined(__hpux) && !defined(__OpenBSD__) && !defined(_AIX)
@@ -1091,6 +1097,22 @@ extern int32 sim_asynch_inst_latency;
         AIO_UPDATE_QUEUE;                                         \
         } while (0)
 
+/* Host time, and the queue to activation latency of asynchronous events,
+   which SHOW ASYNCH reports.  The time is monotonic, so that a step of the
+   wall clock does not show up as latency. */
+#define AIO_TIME_NS(ns)    ns = sim_os_nsec ()
+#define AIO_NOTE_LATENCY(uptr, now)                               \
+    if (1) {                                                      \
+        t_uint64 _lat = ((now) > (uptr)->a_queue_ns)?             \
+                        (now) - (uptr)->a_queue_ns: 0;            \
+        sim_asynch_lat_cnt = sim_asynch_lat_cnt + 1;              \
+        sim_asynch_lat_sum = sim_asynch_lat_sum + _lat;           \
+        if (_lat > sim_asynch_lat_max)                            \
+            sim_asynch_lat_max = _lat;                            \
+        }                                                         \
+    else                                                          \
+        (void)0
+
 #if defined(__DECC_VER)
 #include <builtins>
 #if defined(__IA64)
@@ -1107,8 +1129,15 @@ extern int32 sim_asynch_inst_latency;
 #endif
 #ifdef USE_AIO_INTRINSICS
 /* This approach uses intrinsics to manage access to the link list head     */
-/* sim_asynch_queue.  This implementation is a completely lock free design  */
-/* which avoids the potential ABA issues.                                   */
+/* sim_asynch_queue, as a lock free multiple producer, single consumer      */
+/* queue.  Producers (I/O and polling threads) push a unit onto the head    */
+/* with a compare and swap.  The simulation thread takes the whole list     */
+/* with a compare and swap against the head it read, and reverses it, so    */
+/* that units are activated in the order they were queued.  A unit is on    */
+/* the list at most once (its a_next is non-NULL while it is), and entries  */
+/* are only removed all at once, by the one consumer, so the head can not   */
+/* suffer from ABA.  A producer never waits for another producer or for the */
+/* consumer, and never holds entries that the consumer can not see.         */
 #define AIO_QUEUE_MODE "Lock free asynchronous event queue access"
 #define AIO_INIT                                                  \
     if (1) {                                                      \
@@ -1147,17 +1176,26 @@ extern int32 sim_asynch_inst_latency;
 #define AIO_QUEUE_VAL (UNIT *)(InterlockedCompareExchangePointer(&sim_asynch_queue, sim_asynch_queue, NULL))
 #define AIO_QUEUE_SET(val, queue) (UNIT *)(InterlockedCompareExchangePointer(&sim_asynch_queue, val, queue))
 #define AIO_UPDATE_QUEUE                                                         \
-    if (AIO_QUEUE_VAL != QUEUE_LIST_END) { /* List !Empty */                     \
-      UNIT *q, *uptr;                                                            \
+    if (sim_asynch_queue != QUEUE_LIST_END) { /* List !Empty */                  \
+      UNIT *q, *uptr, *list = QUEUE_LIST_END;                                    \
       int32 a_event_time;                                                        \
+      t_uint64 a_now;                                                            \
       do                                                                         \
-        q = AIO_QUEUE_VAL;                                                       \
-        while (q != AIO_QUEUE_SET(QUEUE_LIST_END, q));                           \
-      while (q != QUEUE_LIST_END) {   /* List !Empty */                          \
-        sim_debug (SIM_DBG_AIO_QUEUE, sim_dflt_dev, "Migrating Asynch event for %s after %d instructions\n", sim_uname(q), q->a_event_time);\
+        q = sim_asynch_queue;                                                    \
+        while (q != AIO_QUEUE_SET(QUEUE_LIST_END, q));/* Take whole list */      \
+      AIO_TIME_NS (a_now);                                                       \
+      while (q != QUEUE_LIST_END) {   /* Reverse into queueing order */          \
         uptr = q;                                                                \
         q = q->a_next;                                                           \
+        uptr->a_next = list;                                                     \
+        list = uptr;                                                             \
+        }                                                                        \
+      while (list != QUEUE_LIST_END) {                                           \
+        sim_debug (SIM_DBG_AIO_QUEUE, sim_dflt_dev, "Migrating Asynch event for %s after %d instructions\n", sim_uname(list), list->a_event_time);\
+        uptr = list;                                                             \
+        list = list->a_next;                                                     \
         uptr->a_next = NULL;        /* hygiene */                                \
+        AIO_NOTE_LATENCY (uptr, a_now);                                          \
         if (uptr->a_activate_call != &sim_activate_notbefore) {                  \
           a_event_time = uptr->a_event_time-((sim_asynch_inst_latency+1)/2);     \
           if (a_event_time < 0)                                                  \
@@ -1179,21 +1217,14 @@ extern int32 sim_asynch_inst_latency;
       if (ouptr->a_next) {                                                       \
         ouptr->a_activate_call = sim_activate_abs;                               \
       } else {                                                                   \
-        UNIT *q, *qe;                                                            \
+        UNIT *q;                                                                 \
         ouptr->a_event_time = event_time;                                        \
         ouptr->a_activate_call = caller;                                         \
-        ouptr->a_next = QUEUE_LIST_END;                 /* Mark as on list */    \
+        AIO_TIME_NS (ouptr->a_queue_ns);                                         \
         do {                                                                     \
-          do                                                                     \
-            q = AIO_QUEUE_VAL;                                                   \
-            while (q != AIO_QUEUE_SET(QUEUE_LIST_END, q));/* Grab current list */\
-          for (qe = ouptr; qe->a_next != QUEUE_LIST_END; qe = qe->a_next);       \
-          qe->a_next = q;                               /* append current list */\
-          do                                                                     \
-            q = AIO_QUEUE_VAL;                                                   \
-            while (q != AIO_QUEUE_SET(ouptr, q));                                \
-          ouptr = q;                                                             \
-          } while (ouptr != QUEUE_LIST_END);                                     \
+          q = sim_asynch_queue;                                                  \
+          ouptr->a_next = q;                            /* link to head */       \
+          } while (q != AIO_QUEUE_SET(ouptr, q));       /* and push */           \
       }                                                                          \
       sim_asynch_check = 0;                             /* try to force check */ \
       if (sim_idle_wait) {                                                       \
@@ -1204,30 +1235,26 @@ extern int32 sim_asynch_inst_latency;
     } else (void)0
 #define AIO_ACTIVATE_LIST(caller, list, event_time)                              \
     if (list) {                                                                  \
-      UNIT *ouptr, *q, *qe;                                                      \
+      UNIT *q, *qe;                                                              \
+      t_uint64 a_now;                                                            \
       sim_debug (SIM_DBG_AIO_QUEUE, sim_dflt_dev, "Queueing Asynch events for %s after %d instructions\n", sim_uname(list), event_time);\
+      AIO_TIME_NS (a_now);                                                       \
       for (qe=(list); qe->a_next != QUEUE_LIST_END;) {                           \
           qe->a_event_time = event_time;                                         \
           qe->a_activate_call = caller;                                          \
+          qe->a_queue_ns = a_now;                                                \
           qe = qe->a_next;                                                       \
           }                                                                      \
       qe->a_event_time = event_time;                                             \
       qe->a_activate_call = caller;                                              \
-      ouptr = (list);                                                            \
+      qe->a_queue_ns = a_now;                                                    \
       do {                                                                       \
-        do                                                                       \
-          q = AIO_QUEUE_VAL;                                                     \
-          while (q != AIO_QUEUE_SET(QUEUE_LIST_END, q));/* Grab current list */  \
-        for (qe = ouptr; qe->a_next != QUEUE_LIST_END; qe = qe->a_next);         \
-        qe->a_next = q;                               /* append current list */  \
-        do                                                                       \
-          q = AIO_QUEUE_VAL;                                                     \
-          while (q != AIO_QUEUE_SET(ouptr, q));                                  \
-        ouptr = q;                                                               \
-        } while (ouptr != QUEUE_LIST_END);                                       \
+        q = sim_asynch_queue;                                                    \
+        qe->a_next = q;                                 /* link tail to head */  \
+        } while (q != AIO_QUEUE_SET((list), q));        /* and push */           \
       sim_asynch_check = 0;                             /* try to force check */ \
       if (sim_idle_wait) {                                                       \
-        sim_debug (TIMER_DBG_IDLE, &sim_timer_dev, "waking due to event on %s after %d instructions\n", sim_uname(ouptr), event_time);\
+        sim_debug (TIMER_DBG_IDLE, &sim_timer_dev, "waking due to event on %s after %d instructions\n", sim_uname(list), event_time);\
         pthread_cond_signal (&sim_asynch_wake);                                  \
         }                                                                        \
       } else (void)0
@@ -1271,6 +1298,8 @@ extern int32 sim_asynch_inst_latency;
 #define AIO_UPDATE_QUEUE                                                         \
     if (1) {                                                                     \
       UNIT *uptr;                                                                \
+      t_uint64 a_now;                                                            \
+      AIO_TIME_NS (a_now);                                                       \
       AIO_LOCK;                                                                  \
       while (sim_asynch_queue != QUEUE_LIST_END) { /* List !Empty */             \
         int32 a_event_time;                                                      \
@@ -1278,6 +1307,7 @@ extern int32 sim_asynch_inst_latency;
         sim_debug (SIM_DBG_AIO_QUEUE, sim_dflt_dev, "Migrating Asynch event for %s after %d instructions\n", sim_uname(uptr), uptr->a_event_time);\
         sim_asynch_queue = uptr->a_next;                                         \
         uptr->a_next = NULL;            /* hygiene */                            \
+        AIO_NOTE_LATENCY (uptr, a_now);                                          \
         if (uptr->a_activate_call != &sim_activate_notbefore) {                  \
           a_event_time = uptr->a_event_time-((sim_asynch_inst_latency+1)/2);     \
           if (a_event_time < 0)                                                  \
@@ -1305,6 +1335,7 @@ extern int32 sim_asynch_inst_latency;
         uptr->a_next = sim_asynch_queue;                               \
         uptr->a_event_time = event_time;                               \
         uptr->a_activate_call = caller;                                \
+        AIO_TIME_NS (uptr->a_queue_ns);                                \
         sim_asynch_queue = uptr;                                       \
       }                                                                \
       if (sim_idle_wait) {                                             \
@@ -1318,14 +1349,18 @@ extern int32 sim_asynch_inst_latency;
 #define AIO_ACTIVATE_LIST(caller, list, event_time)                              \
     if (list) {                                                                  \
       UNIT *qe;                                                                  \
+      t_uint64 a_now;                                                            \
       sim_debug (SIM_DBG_AIO_QUEUE, sim_dflt_dev, "Queueing Asynch events for %s after %d instructions\n", sim_uname(list), event_time);\
+      AIO_TIME_NS (a_now);                                                       \
       for (qe=list; qe->a_next != QUEUE_LIST_END;) {                             \
           qe->a_event_time = event_time;                                         \
           qe->a_activate_call = caller;                                          \
+          qe->a_queue_ns = a_now;                                                \
           qe = qe->a_next;                                                       \
           }                                                                      \
       qe->a_event_time = event_time;                                             \
       qe->a_activate_call = caller;                                              \
+      qe->a_queue_ns = a_now;                                                    \
       AIO_LOCK;                                                                  \
       qe->a_next = sim_asynch_queue;                                             \
       sim_asynch_queue = list;                                                   \
@@ -1343,6 +1378,12 @@ extern int32 sim_asynch_inst_latency;
       AIO_UPDATE_QUEUE;                                                \
       sim_asynch_check = sim_asynch_inst_latency;                      \
     } else (void)0
+/* For simulators which run instructions in batches: n more instructions */
+#define AIO_CHECK_EVENTS(n)                                            \
+    if (0 > (sim_asynch_check = sim_asynch_check - (n))) {             \
+      AIO_UPDATE_QUEUE;                                                \
+      sim_asynch_check = sim_asynch_inst_latency;                      \
+    } else (void)0
 #define AIO_SET_INTERRUPT_LATENCY(instpersec)                                                   \
     if (1) {                                                                                    \
       sim_asynch_inst_latency = (int32)((((double)(instpersec))*sim_asynch_latency)/1000000000);\
@@ -1355,6 +1396,7 @@ extern int32 sim_asynch_inst_latency;
 #define AIO_ACTIVATE(caller, uptr, event_time)
 #define AIO_VALIDATE
 #define AIO_CHECK_EVENT
+#define AIO_CHECK_EVENTS(n)
 #define AIO_INIT
 #define AIO_MAIN_THREAD TRUE
 #define AIO_LOCK
@@ -52,6 +52,7 @@
    sim_buf_swap_data -       swap data elements inplace in buffer
    sim_shmem_open            create or attach to a shared memory region
    sim_shmem_close           close a shared memory region
+   sim_fopen_private         open a file shared, with private writes
 
 
    sim_fopen and sim_fseek are OS-dependent.  The other routines are not.
@@ -517,3 +518,140 @@ free (shmem);
 }
 
 #endif
+
+/* Open a file shared, with private writes
+
+   The file is mapped copy on write.  Its pages are shared, through the
+   page cache, with every other simulator that maps it, until this one
+   writes them; the writes are never written back, and last until the
+   stream is closed.  The stream covers at least size bytes, reading zero
+   past the end of the file, so that a short image can still be written to
+   its full capacity.  Returns NULL if the host cannot do this. */
+
+#if !defined (_WIN32) && defined (__GLIBC__)
+
+typedef struct {
+    char                *base;                          /* mapping */
+    size_t              len;                            /* mapping length */
+    size_t              end;                            /* logical size */
+    off64_t             pos;                            /* position */
+    } PRIVFILE;
+
+static ssize_t priv_read (void *cookie, char *buf, size_t n)
+{
+PRIVFILE *pf = (PRIVFILE *) cookie;
+
+if (pf->pos >= (off64_t) pf->end)
+    return 0;
+if (n > pf->end - (size_t) pf->pos)
+    n = pf->end - (size_t) pf->pos;
+memcpy (buf, pf->base + pf->pos, n);
+pf->pos = pf->pos + n;
+return (ssize_t) n;
+}
+
+static ssize_t priv_write (void *cookie, const char *buf, size_t n)
+{
+PRIVFILE *pf = (PRIVFILE *) cookie;
+
+if (pf->pos >= (off64_t) pf->len) {                     /* no room? */
+    errno = ENOSPC;
+    return 0;
+    }
+if (n > pf->len - (size_t) pf->pos)
+    n = pf->len - (size_t) pf->pos;
+memcpy (pf->base + pf->pos, buf, n);
+pf->pos = pf->pos + n;
+if ((size_t) pf->pos > pf->end)                         /* grown? */
+    pf->end = (size_t) pf->pos;
+return (ssize_t) n;
+}
+
+static int priv_seek (void *cookie, off64_t *offset, int whence)
+{
+PRIVFILE *pf = (PRIVFILE *) cookie;
+off64_t pos;
+
+switch (whence) {
+    case SEEK_SET:
+        pos = *offset;
+        break;
+    case SEEK_CUR:
+        pos = pf->pos + *offset;
+        break;
+    case SEEK_END:
+        pos = (off64_t) pf->end + *offset;
+        break;
+    default:
+        pos = -1;
+        }
+if ((pos < 0) || (pos > (off64_t) pf->len)) {
+    errno = EINVAL;
+    return -1;
+    }
+*offset = pf->pos = pos;
+return 0;
+}
+
+static int priv_close (void *cookie)
+{
+PRIVFILE *pf = (PRIVFILE *) cookie;
+
+munmap (pf->base, pf->len);
+free (pf);
+return 0;
+}
+
+FILE *sim_fopen_private (const char *file, t_offset size)
+{
+static cookie_io_functions_t priv_io = {
+    &priv_read, &priv_write, &priv_seek, &priv_close
+    };
+PRIVFILE *pf;
+struct stat statb;
+FILE *fp;
+int fd;
+
+fd = open (file, O_RDONLY);
+if (fd < 0)
+    return NULL;
+pf = (PRIVFILE *) calloc (1, sizeof (*pf));
+if ((pf == NULL) || fstat (fd, &statb))
+    goto fail;
+pf->end = (size_t) statb.st_size;
+pf->len = (size > statb.st_size)? (size_t) size: (size_t) statb.st_size;
+if (pf->len == 0)
+    pf->len = 1;
+pf->base = (char *) mmap (NULL, pf->len, PROT_READ | PROT_WRITE,
+    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);                /* zeroes, */
+if (pf->base == MAP_FAILED)
+    goto fail;
+if ((pf->end != 0) &&                                   /* the file over them */
+    (mmap (pf->base, pf->end, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED)) {
+    munmap (pf->base, pf->len);
+    goto fail;
+    }
+close (fd);
+fp = fopencookie (pf, "r+", priv_io);
+if (fp == NULL) {
+    priv_close (pf);
+    return NULL;
+    }
+setvbuf (fp, NULL, _IONBF, 0);                          /* already in memory */
+return fp;
+
+fail:
+free (pf);
+close (fd);
+return NULL;
+}
+
+#else
+
+FILE *sim_fopen_private (const char *file, t_offset size)
+{
+return NULL;
+}
+
+#endif
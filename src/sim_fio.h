@@ -51,6 +51,7 @@ typedef int32        t_offset;
 #endif
 #endif
 FILE *sim_fopen (const char *file, const char *mode);
+FILE *sim_fopen_private (const char *file, t_offset size);
 int sim_fseek (FILE *st, t_addr offset, int whence);
 int sim_fseeko (FILE *st, t_offset offset, int whence);
 int sim_set_fsize (FILE *fptr, t_addr size);
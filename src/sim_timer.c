@@ -65,7 +65,9 @@
    sim_rtc_calb -           calibrate clock
    sim_timer_init -         initialize timing system
    sim_idle -               virtual machine idle
+   sim_os_idle_until -      sleep until a monotonic deadline or input
    sim_os_msec  -           return elapsed time in msec
+   sim_os_nsec  -           return monotonic elapsed time in nsec
    sim_os_sleep -           sleep specified number of seconds
    sim_os_ms_sleep -        sleep specified number of milliseconds
    sim_idle_ms_sleep -      sleep specified number of milliseconds
@@ -94,8 +96,10 @@ static uint32 sim_idle_rate_ms = 0;
 static uint32 sim_os_sleep_min_ms = 0;
 static uint32 sim_idle_stable = SIM_IDLE_STDFLT;
 static t_bool sim_idle_idled = FALSE;
-static uint32 sim_throt_ms_start = 0;
-static uint32 sim_throt_ms_stop = 0;
+static t_bool sim_idle_tickless = SIM_TICKLESS;         /* tickless idle */
+static double sim_idle_late_ns = 0;                     /* smoothed host wakeup delay */
+static t_uint64 sim_throt_ns_start = 0;
+static t_uint64 sim_throt_ns_stop = 0;
 static uint32 sim_throt_type = 0;
 static uint32 sim_throt_val = 0;
 static uint32 sim_throt_state = 0;
@@ -208,6 +212,14 @@ for (i = 0; i < 64; i++) {                              /* 64b quo */
 return quo;
 }
 
+t_uint64 sim_os_nsec (void)
+{
+uint32 tod[2];
+
+sys$gettim (tod);                                       /* time 0.1usec */
+return ((((t_uint64) tod[1]) << 32) | tod[0]) * 100;
+}
+
 void sim_os_sleep (unsigned int sec)
 {
 sleep (sec);
@@ -269,6 +281,15 @@ if (sim_idle_rate_ms)
 else return GetTickCount ();
 }
 
+t_uint64 sim_os_nsec (void)
+{
+LARGE_INTEGER cnt, freq;
+
+if (!QueryPerformanceFrequency (&freq) || !QueryPerformanceCounter (&cnt))
+    return ((t_uint64) sim_os_msec ()) * 1000000;
+return (t_uint64) (((double) cnt.QuadPart) * 1000000000.0 / (double) freq.QuadPart);
+}
+
 void sim_os_sleep (unsigned int sec)
 {
 Sleep (sec * 1000);
@@ -337,6 +358,11 @@ uint32 sim_os_msec (void)
 return 0;
 }
 
+t_uint64 sim_os_nsec (void)
+{
+return 0;
+}
+
 void sim_os_sleep (unsigned int sec)
 {
 return;
@@ -378,6 +404,14 @@ millis = micros / 1000LL;
 return (uint32) millis;
 }
 
+t_uint64 sim_os_nsec (void)
+{
+UnsignedWide macMicros;
+
+Microseconds (&macMicros);
+return (*((unsigned long long *) &macMicros)) * 1000LL;
+}
+
 void sim_os_sleep (unsigned int sec)
 {
 sleep (sec);
@@ -439,6 +473,20 @@ msec = (((uint32) cur.tv_sec) * 1000) + (((uint32) cur.tv_usec) / 1000);
 return msec;
 }
 
+/* Monotonic time, for measuring intervals: unlike the time of day, it is
+   not stepped by NTP or by setting the date, and it has nsec resolution */
+
+t_uint64 sim_os_nsec (void)
+{
+#if defined (CLOCK_MONOTONIC)
+struct timespec now;
+
+if (clock_gettime (CLOCK_MONOTONIC, &now) == 0)
+    return (((t_uint64) now.tv_sec) * 1000000000) + now.tv_nsec;
+#endif
+return ((t_uint64) sim_os_msec ()) * 1000000;
+}
+
 void sim_os_sleep (unsigned int sec)
 {
 sleep (sec);
@@ -493,6 +541,79 @@ return sim_os_msec () - stime;
 
 #endif
 
+/* Tickless idle
+
+   sim_os_idle_until sleeps until an absolute CLOCK_MONOTONIC deadline, on a
+   timerfd, or until input arrives on the keyboard (when it is a terminal)
+   or on a socket or serial port of an open multiplexer.  Descriptors which
+   are already readable are not watched: their input is waiting for the
+   next poll anyway, and would otherwise end every sleep at once.  Returns
+   TRUE if input ended the sleep. */
+
+#if SIM_TICKLESS
+#include "sim_tmxr.h"
+#include <poll.h>
+#include <sys/timerfd.h>
+
+#define SIM_IDLE_MAXFD  64                              /* max fds watched */
+
+t_bool sim_os_idle_until (t_uint64 deadline)
+{
+static int tfd = -1;
+struct itimerspec its;
+struct pollfd pfd[SIM_IDLE_MAXFD + 1];
+int fds[SIM_IDLE_MAXFD];
+uint32 i, n, nfd;
+uint64_t expired;
+t_uint64 now;
+
+if (tfd < 0) {
+    tfd = timerfd_create (CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (tfd < 0) {                                      /* no timerfd? */
+        now = sim_os_nsec ();
+        sim_os_ms_sleep ((now >= deadline)? 0:          /* passed? don't wrap */
+            (unsigned int) ((deadline - now) / 1000000));
+        return FALSE;
+        }
+    }
+n = (uint32) tmxr_idle_fds (fds, SIM_IDLE_MAXFD - 1);   /* mux descriptors */
+if (isatty (0))                                         /* and the keyboard */
+    fds[n++] = 0;
+for (i = 0; i < n; i++) {                               /* watch these */
+    pfd[i].fd = fds[i];
+    pfd[i].events = POLLIN;
+    pfd[i].revents = 0;
+    }
+if (n && (poll (pfd, n, 0) > 0)) {                      /* some ready already? */
+    for (i = nfd = 0; i < n; i++)                       /* drop them */
+        if (pfd[i].revents == 0)
+            pfd[nfd++] = pfd[i];
+    }
+else nfd = n;
+memset (&its, 0, sizeof (its));
+its.it_value.tv_sec = (time_t) (deadline / 1000000000);
+its.it_value.tv_nsec = (long) (deadline % 1000000000);
+if ((its.it_value.tv_sec == 0) && (its.it_value.tv_nsec == 0))
+    its.it_value.tv_nsec = 1;                           /* 0 would disarm */
+timerfd_settime (tfd, TFD_TIMER_ABSTIME, &its, NULL);
+pfd[nfd].fd = tfd;
+pfd[nfd].events = POLLIN;
+pfd[nfd].revents = 0;
+while (poll (pfd, nfd + 1, -1) < 0) {                   /* wait */
+    if (errno != EINTR)
+        return FALSE;
+    if (stop_cpu)                                       /* ^E? */
+        return TRUE;
+    }
+if (pfd[nfd].revents & POLLIN) {                        /* deadline? */
+    if (read (tfd, &expired, sizeof (expired)) < 0)     /* clear it */
+        expired = 0;
+    return FALSE;
+    }
+return TRUE;                                            /* input */
+}
+#endif
+
 /* diff = min - sub */
 void
 sim_timespec_diff (struct timespec *diff, struct timespec *min, struct timespec *sub)
@@ -541,10 +662,13 @@ else
 
 static int32 rtc_ticks[SIM_NTIMERS] = { 0 };            /* ticks */
 static int32 rtc_hz[SIM_NTIMERS] = { 0 };               /* tick rate */
-static uint32 rtc_rtime[SIM_NTIMERS] = { 0 };           /* real time */
-static uint32 rtc_vtime[SIM_NTIMERS] = { 0 };           /* virtual time */
+static t_uint64 rtc_rtime[SIM_NTIMERS] = { 0 };         /* real time, nsec */
+static t_uint64 rtc_vtime[SIM_NTIMERS] = { 0 };         /* virtual time, nsec */
 static double rtc_gtime[SIM_NTIMERS] = { 0 };           /* instruction time */
-static uint32 rtc_nxintv[SIM_NTIMERS] = { 0 };          /* next interval */
+static int32 rtc_nxintv[SIM_NTIMERS] = { 0 };           /* next interval, usec */
+static double rtc_ips[SIM_NTIMERS] = { 0 };             /* smoothed inst/sec */
+static double rtc_ips_meas[SIM_NTIMERS] = { 0 };        /* last second's inst/sec */
+static double rtc_tick_err[SIM_NTIMERS] = { 0 };        /* last second's tick error, nsec */
 static int32 rtc_based[SIM_NTIMERS] = { 0 };            /* base delay */
 static int32 rtc_currd[SIM_NTIMERS] = { 0 };            /* current delay */
 static int32 rtc_initd[SIM_NTIMERS] = { 0 };            /* initial delay */
@@ -581,9 +705,13 @@ if (uptr) {
     sim_clock_unit[tmr] = uptr;
     sim_clock_cosched_queue[tmr] = QUEUE_LIST_END;
     }
-rtc_rtime[tmr] = sim_os_msec ();
+rtc_rtime[tmr] = sim_os_nsec ();
 rtc_vtime[tmr] = rtc_rtime[tmr];
-rtc_nxintv[tmr] = 1000;
+rtc_nxintv[tmr] = 1000000;
+rtc_gtime[tmr] = sim_gtime ();
+rtc_ips[tmr] = 0;
+rtc_ips_meas[tmr] = 0;
+rtc_tick_err[tmr] = 0;
 rtc_ticks[tmr] = 0;
 rtc_hz[tmr] = 0;
 rtc_based[tmr] = time;
@@ -596,12 +724,22 @@ if (sim_calb_tmr == -1)                 /* save first initialized clock as the s
 return time;
 }
 
+/* Calibration works in nsec of monotonic host time.  Once a second of
+   ticks, the instructions executed over the elapsed host time give a
+   measured rate, which is smoothed (SIM_CAL_SMOOTH) so that one slow or
+   fast second on a busy host does not swing the tick delay.  The next
+   second is stretched or shrunk by the gap between virtual and host time,
+   up to SIM_TMAX msec, so that the ticks do not drift from host time.
+   A second in which the simulator idled tells nothing about its rate:
+   the smoothed rate is kept, and only the gap is corrected. */
+
 int32 sim_rtcn_calb (int32 ticksper, int32 tmr)
 {
-uint32 new_rtime, delta_rtime;
-int32 delta_vtime;
+t_uint64 new_rtime, delta_rtime;
+t_int64 delta_vtime;
 double new_gtime;
 int32 new_currd;
+t_bool idled;
 
 if ((tmr < 0) || (tmr >= SIM_NTIMERS))
     return 10000;
@@ -615,16 +753,10 @@ rtc_elapsed[tmr] = rtc_elapsed[tmr] + 1;                /* count sec */
 if (!rtc_avail) {                                       /* no timer? */
     return rtc_currd[tmr];
     }
-new_rtime = sim_os_msec ();                             /* wall time */
-sim_debug (DBG_TRC, &sim_timer_dev, "sim_rtcn_calb(ticksper=%d, tmr=%d) rtime=%d\n", ticksper, tmr, new_rtime);
-if (sim_idle_idled) {
-    rtc_rtime[tmr] = new_rtime;                         /* save wall time */
-    rtc_vtime[tmr] = rtc_vtime[tmr] + 1000;             /* adv sim time */
-    rtc_gtime[tmr] = sim_gtime();                       /* save instruction time */
-    sim_idle_idled = FALSE;                             /* reset idled flag */
-    sim_debug (DBG_CAL, &sim_timer_dev, "skipping calibration due to idling - result: %d\n", rtc_currd[tmr]);
-    return rtc_currd[tmr];                              /* avoid calibrating idle checks */
-    }
+new_rtime = sim_os_nsec ();                             /* wall time */
+sim_debug (DBG_TRC, &sim_timer_dev, "sim_rtcn_calb(ticksper=%d, tmr=%d) rtime=%.0f\n", ticksper, tmr, (double) new_rtime);
+idled = sim_idle_idled;                                 /* slept this second? */
+sim_idle_idled = FALSE;                                 /* reset idled flag */
 if (new_rtime < rtc_rtime[tmr]) {                       /* time running backwards? */
     rtc_rtime[tmr] = new_rtime;                         /* reset wall time */
     sim_debug (DBG_CAL, &sim_timer_dev, "time running backwards - result: %d\n", rtc_currd[tmr]);
@@ -633,11 +765,13 @@ if (new_rtime < rtc_rtime[tmr]) {                       /* time running backward
 ++rtc_calibrations[tmr];                                /* count calibrations */
 delta_rtime = new_rtime - rtc_rtime[tmr];               /* elapsed wtime */
 rtc_rtime[tmr] = new_rtime;                             /* adv wall time */
-rtc_vtime[tmr] = rtc_vtime[tmr] + 1000;                 /* adv sim time */
-if (delta_rtime > 30000) {                              /* gap too big? */
+rtc_vtime[tmr] = rtc_vtime[tmr] + 1000000000;           /* adv sim time */
+if (delta_rtime > (t_uint64) 30000000000) {             /* gap too big? */
     rtc_currd[tmr] = rtc_initd[tmr];
+    rtc_vtime[tmr] = rtc_rtime[tmr];                    /* start over */
+    rtc_ips[tmr] = 0;
     rtc_gtime[tmr] = sim_gtime();                       /* save instruction time */
-    sim_debug (DBG_CAL, &sim_timer_dev, "gap too big: delta = %d - result: %d\n", delta_rtime, rtc_initd[tmr]);
+    sim_debug (DBG_CAL, &sim_timer_dev, "gap too big: delta = %.0fms - result: %d\n", delta_rtime / 1000000.0, rtc_initd[tmr]);
     return rtc_initd[tmr];                              /* can't calibr */
     }
 new_gtime = sim_gtime();
@@ -667,22 +801,28 @@ if (sim_asynch_enabled && sim_asynch_timer) {
         return rtc_initd[tmr];                          /* initial result until stable */
         }
     }
+if (delta_rtime == 0) {                                 /* gap too small? */
+    sim_debug (DBG_CAL, &sim_timer_dev, "no elapsed time - result: %d\n", rtc_currd[tmr]);
+    return rtc_currd[tmr];
+    }
+rtc_ips_meas[tmr] = ((new_gtime - rtc_gtime[tmr]) * 1000000000.0) /
+    ((double) delta_rtime);                             /* measured rate */
+rtc_tick_err[tmr] = (((double) delta_rtime) - 1000000000.0) / ticksper;
 rtc_gtime[tmr] = new_gtime;                             /* save instruction time */
-/* This self regulating algorithm depends directly on the assumption */
-/* that this routine is called back after processing the number of */
-/* instructions which was returned the last time it was called. */
-if (delta_rtime == 0)                                   /* gap too small? */
-    rtc_based[tmr] = rtc_based[tmr] * ticksper;         /* slew wide */
-else rtc_based[tmr] = (int32) (((double) rtc_based[tmr] * (double) rtc_nxintv[tmr]) /
-    ((double) delta_rtime));                            /* new base rate */
-delta_vtime = rtc_vtime[tmr] - rtc_rtime[tmr];          /* gap */
-if (delta_vtime > SIM_TMAX)                             /* limit gap */
-    delta_vtime = SIM_TMAX;
-else if (delta_vtime < -SIM_TMAX)
-    delta_vtime = -SIM_TMAX;
-rtc_nxintv[tmr] = 1000 + delta_vtime;                   /* next wtime */
+if (rtc_ips[tmr] == 0)                                  /* first second? */
+    rtc_ips[tmr] = rtc_ips_meas[tmr];
+else if (!idled)                                        /* ran throughout? */
+    rtc_ips[tmr] = rtc_ips[tmr] +                       /* smooth */
+        ((rtc_ips_meas[tmr] - rtc_ips[tmr]) / SIM_CAL_SMOOTH);
+rtc_based[tmr] = (int32) (rtc_ips[tmr] / ticksper);     /* new base rate */
+delta_vtime = (t_int64) (rtc_vtime[tmr] - rtc_rtime[tmr]);
+if (delta_vtime > (SIM_TMAX * 1000000))                 /* limit gap */
+    delta_vtime = SIM_TMAX * 1000000;
+else if (delta_vtime < -(SIM_TMAX * 1000000))
+    delta_vtime = -(SIM_TMAX * 1000000);
+rtc_nxintv[tmr] = 1000000 + (int32) (delta_vtime / 1000); /* next wtime */
 rtc_currd[tmr] = (int32) (((double) rtc_based[tmr] * (double) rtc_nxintv[tmr]) /
-    1000.0);                                            /* next delay */
+    1000000.0);                                         /* next delay */
 if (rtc_based[tmr] <= 0)                                /* never negative or zero! */
     rtc_based[tmr] = 1;
 if (rtc_currd[tmr] <= 0)                                /* never negative or zero! */
@@ -704,6 +844,26 @@ int32 sim_rtc_calb (int32 ticksper)
 return sim_rtcn_calb (ticksper, 0);
 }
 
+/* Calibration state - for simulators which record a run and replay it,
+   where the calibrated delay must come from the recording rather than
+   from the wall clock */
+
+void sim_rtcn_get_cal (int32 tmr, int32 *ticksper, int32 *currd)
+{
+if ((tmr < 0) || (tmr >= SIM_NTIMERS))
+    return;
+*ticksper = rtc_hz[tmr];
+*currd = rtc_currd[tmr];
+}
+
+void sim_rtcn_set_cal (int32 tmr, int32 ticksper, int32 currd)
+{
+if ((tmr < 0) || (tmr >= SIM_NTIMERS) || (currd <= 0))
+    return;
+rtc_hz[tmr] = ticksper;
+rtc_currd[tmr] = currd;
+}
+
 /* sim_timer_init - get minimum sleep time available on this host */
 
 t_bool sim_timer_init (void)
@@ -753,13 +913,18 @@ for (tmr=clocks=0; tmr<SIM_NTIMERS; ++tmr) {
     fprintf (st, "  Calibrations:            %u\n",   rtc_calibrations[tmr]);
     fprintf (st, "  Instruction Time:        %.0f\n", rtc_gtime[tmr]);
     if (!(sim_asynch_enabled && sim_asynch_timer)) {
-        fprintf (st, "  Real Time:               %u\n",   rtc_rtime[tmr]);
-        fprintf (st, "  Virtual Time:            %u\n",   rtc_vtime[tmr]);
-        fprintf (st, "  Next Interval:           %u\n",   rtc_nxintv[tmr]);
+        fprintf (st, "  Real Time:               %.0fns\n", (double) rtc_rtime[tmr]);
+        fprintf (st, "  Virtual Time:            %.0fns\n", (double) rtc_vtime[tmr]);
+        fprintf (st, "  Next Interval:           %dus\n", rtc_nxintv[tmr]);
         fprintf (st, "  Base Tick Delay:         %d\n",   rtc_based[tmr]);
         fprintf (st, "  Initial Insts Per Tick:  %d\n",   rtc_initd[tmr]);
         }
     fprintf (st, "  Current Insts Per Tick:  %d\n",   rtc_currd[tmr]);
+    if (rtc_ips_meas[tmr] != 0) {
+        fprintf (st, "  Measured Insts Per Sec:  %.0f, smoothed %.0f\n", rtc_ips_meas[tmr], rtc_ips[tmr]);
+        fprintf (st, "  Tick Error:              %.1fus per tick, %.3fms ahead of host\n",
+            rtc_tick_err[tmr] / 1000.0, ((double) (t_int64) (rtc_vtime[tmr] - rtc_rtime[tmr])) / 1000000.0);
+        }
     if (rtc_clock_skew_max[tmr] != 0.0)
         fprintf (st, "  Peak Clock Skew:         %.0fms\n",   rtc_clock_skew_max[tmr]);
     }
@@ -823,8 +988,8 @@ REG sim_timer_reg[] = {
     { DRDATAD (IDLE_STABLE,      sim_idle_stable,        32, "Idle Stable"), PV_RSPC},
     { FLDATAD (IDLE_IDLED,       sim_idle_idled,          0, ""), REG_RO},
     { DRDATAD (TMR,              sim_calb_tmr,           32, ""), PV_RSPC|REG_RO},
-    { DRDATAD (THROT_MS_START,   sim_throt_ms_start,     32, ""), PV_RSPC|REG_RO},
-    { DRDATAD (THROT_MS_STOP,    sim_throt_ms_stop,      32, ""), PV_RSPC|REG_RO},
+    { DRDATAD (THROT_NS_START,   sim_throt_ns_start,     64, ""), PV_RSPC|REG_RO},
+    { DRDATAD (THROT_NS_STOP,    sim_throt_ns_stop,      64, ""), PV_RSPC|REG_RO},
     { DRDATAD (THROT_TYPE,       sim_throt_type,         32, ""), PV_RSPC|REG_RO},
     { DRDATAD (THROT_VAL,        sim_throt_val,          32, ""), PV_RSPC|REG_RO},
     { DRDATAD (THROT_STATE,      sim_throt_state,        32, ""), PV_RSPC|REG_RO},
@@ -861,11 +1026,33 @@ fprintf (st, "%s", (sim_asynch_enabled && sim_asynch_timer) ? "Asynchronous" : "
 return SCPE_OK;
 }
 
+/* Set, clear and show tickless idle */
+
+t_stat sim_timer_set_tickless (UNIT *uptr, int32 val, char *cptr, void *desc)
+{
+if (cptr && *cptr)
+    return SCPE_ARG;
+if (val && !SIM_TICKLESS)
+    return sim_messagef (SCPE_NOFNC, "Tickless idle is not available on this host\n");
+sim_idle_tickless = val? TRUE: FALSE;
+return SCPE_OK;
+}
+
+t_stat sim_timer_show_tickless (FILE *st, UNIT *uptr, int32 val, void *desc)
+{
+fprintf (st, "%s", sim_idle_tickless ? "Tickless idle" : "Idle on host ticks");
+if (sim_idle_tickless && (sim_switches & SWMASK ('D')))
+    fprintf (st, ", wakeup delay %.0fus", sim_idle_late_ns / 1000.0);
+return SCPE_OK;
+}
+
 MTAB sim_timer_mod[] = {
 #if defined (SIM_ASYNCH_IO) && defined (SIM_ASYNCH_CLOCKS)
   { MTAB_VDV,          MTAB_VDV, "ASYNC", "ASYNC",   &sim_timer_set_async, &sim_timer_show_async, NULL, "Enables/Displays Asynchronous Timer operation mode" },
   { MTAB_VDV,                 0,    NULL, "NOASYNC", &sim_timer_clr_async, NULL,                  NULL, "Disables Asynchronous Timer operation" },
 #endif
+  { MTAB_VDV,                 1, "TICKLESS", "TICKLESS", &sim_timer_set_tickless, &sim_timer_show_tickless, NULL, "Enables/Displays idle sleeps to the exact time of the next event" },
+  { MTAB_VDV,                 0,    NULL, "NOTICKLESS", &sim_timer_set_tickless, NULL,                  NULL, "Idle sleeps whole host ticks" },
   { 0 },
 };
 
@@ -891,9 +1078,9 @@ DEVICE sim_timer_dev = {
 
 t_bool sim_idle (uint32 tmr, t_bool sin_cyc)
 {
-static uint32 cyc_ms = 0;
-uint32 w_ms, w_idle, act_ms;
-int32 act_cyc;
+uint32 w_ms, w_idle;
+t_uint64 act_ns;
+double ips, act_cyc;
 
 if ((!sim_idle_enab)                             ||     /* idling disabled */
     ((sim_clock_queue == QUEUE_LIST_END) &&             /* or clock queue empty? */
@@ -930,18 +1117,61 @@ if ((!sim_idle_enab)                             ||     /* idling disabled */
    directly checking sim_idle_enab before calling sim_idle so that all of 
    the bookkeeping on sim_idle_idled is done here in sim_timer where it 
    means something, while not idling when it isn't enabled.  
+
+   Tickless idle sets the flag when it has actually slept; sim_rtcn_calb
+   then keeps the rate it measured while running, and still corrects the
+   drift of virtual from host time.
    */
 //sim_idle_idled = TRUE;                                  /* record idle attempt */
 sim_debug (DBG_TRC, &sim_timer_dev, "sim_idle(tmr=%d, sin_cyc=%d)\n", tmr, sin_cyc);
-if (cyc_ms == 0)                                        /* not computed yet? */
-    cyc_ms = (rtc_currd[tmr] * rtc_hz[tmr]) / 1000;     /* cycles per msec */
-if ((sim_idle_rate_ms == 0) || (cyc_ms == 0)) {         /* not possible? */
+ips = ((double) rtc_based[tmr]) * rtc_hz[tmr];          /* calibrated rate, */
+                                                        /* without catch up */
+if ((sim_idle_rate_ms == 0) || (ips < 1000.0)) {        /* not possible? */
     if (sin_cyc)
         sim_interval = sim_interval - 1;
-    sim_debug (DBG_IDL, &sim_timer_dev, "not possible %d - %d\n", sim_idle_rate_ms, cyc_ms);
+    sim_debug (DBG_IDL, &sim_timer_dev, "not possible %d - %.0f\n", sim_idle_rate_ms, ips);
     return FALSE;
     }
-w_ms = (uint32) sim_interval / cyc_ms;                  /* ms to wait */
+#if SIM_TICKLESS
+/* Tickless, sleep to the exact host time at which the next event is due,
+   made early by the host's smoothed wakeup delay; the few instructions
+   left when it wakes are run, so the event is not late.  Input ends the
+   sleep early, and then the next event is taken at once, so that the
+   poll it carries (or is scheduled with) sees the input. */
+if (sim_idle_tickless && !sim_asynch_enabled) {
+    t_uint64 now, deadline;
+    double w_ns;
+    t_bool input;
+
+    w_ns = (((double) sim_interval) * 1000000000.0) / ips;
+    if (w_ns < (SIM_IDLE_MINUS * 1000.0) + sim_idle_late_ns) {/* too short? */
+        if (sin_cyc)
+            sim_interval = sim_interval - 1;
+        return FALSE;
+        }
+    now = sim_os_nsec ();
+    deadline = now + (t_uint64) (w_ns - sim_idle_late_ns);
+    if (sim_clock_queue == QUEUE_LIST_END)
+        sim_debug (DBG_IDL, &sim_timer_dev, "sleeping for %.0f us - pending event in %d instructions\n", w_ns / 1000.0, sim_interval);
+    else
+        sim_debug (DBG_IDL, &sim_timer_dev, "sleeping for %.0f us - pending event on %s in %d instructions\n", w_ns / 1000.0, sim_uname(sim_clock_queue), sim_interval);
+    input = sim_os_idle_until (deadline);
+    act_ns = sim_os_nsec ();
+    if (!input && (act_ns >= deadline) &&               /* learn wakeup delay, */
+        ((act_ns - deadline) < 1000000))                /* not preemption */
+        sim_idle_late_ns = sim_idle_late_ns +
+            ((((double) (act_ns - deadline)) - sim_idle_late_ns) / 8.0);
+    sim_idle_idled = TRUE;                              /* rate not measurable */
+    act_ns = act_ns - now;                              /* time actually slept */
+    act_cyc = (((double) act_ns) * ips) / 1000000000.0;
+    if (!input && (sim_interval > act_cyc))
+        sim_interval = sim_interval - (int32) act_cyc;  /* count down sim_interval */
+    else sim_interval = 0;                              /* or fire now */
+    sim_debug (DBG_IDL, &sim_timer_dev, "slept for %.0f us%s - pending event in %d instructions\n", act_ns / 1000.0, input? " (input)": "", sim_interval);
+    return TRUE;
+    }
+#endif
+w_ms = (uint32) ((((double) sim_interval) * 1000.0) / ips);/* ms to wait */
 w_idle = w_ms / sim_idle_rate_ms;                       /* intervals to wait */
 if (w_idle == 0) {                                      /* none? */
     if (sin_cyc)
@@ -953,17 +1183,17 @@ if (sim_clock_queue == QUEUE_LIST_END)
     sim_debug (DBG_IDL, &sim_timer_dev, "sleeping for %d ms - pending event in %d instructions\n", w_ms, sim_interval);
 else
     sim_debug (DBG_IDL, &sim_timer_dev, "sleeping for %d ms - pending event on %s in %d instructions\n", w_ms, sim_uname(sim_clock_queue), sim_interval);
-act_ms = SIM_IDLE_MS_SLEEP (w_ms);                      /* wait */
-act_cyc = act_ms * cyc_ms;
-if (act_ms < w_ms)                                      /* awakened early? */
-    act_cyc += (cyc_ms * sim_idle_rate_ms) / 2;         /* account for half an interval's worth of cycles */
+act_ns = sim_os_nsec ();
+SIM_IDLE_MS_SLEEP (w_ms);                               /* wait */
+act_ns = sim_os_nsec () - act_ns;                       /* time actually slept */
+act_cyc = (((double) act_ns) * ips) / 1000000000.0;     /* is worth */
 if (sim_interval > act_cyc)
-    sim_interval = sim_interval - act_cyc;              /* count down sim_interval */
+    sim_interval = sim_interval - (int32) act_cyc;      /* count down sim_interval */
 else sim_interval = 0;                                  /* or fire immediately */
 if (sim_clock_queue == QUEUE_LIST_END)
-    sim_debug (DBG_IDL, &sim_timer_dev, "slept for %d ms - pending event in %d instructions\n", act_ms, sim_interval);
+    sim_debug (DBG_IDL, &sim_timer_dev, "slept for %.3f ms - pending event in %d instructions\n", act_ns / 1000000.0, sim_interval);
 else
-    sim_debug (DBG_IDL, &sim_timer_dev, "slept for %d ms - pending event on %s in %d instructions\n", act_ms, sim_uname(sim_clock_queue), sim_interval);
+    sim_debug (DBG_IDL, &sim_timer_dev, "slept for %.3f ms - pending event on %s in %d instructions\n", act_ns / 1000000.0, sim_uname(sim_clock_queue), sim_interval);
 return TRUE;
 }
 
@@ -1133,8 +1363,7 @@ sim_cancel (&sim_timer_units[SIM_NTIMERS]);
 */
 t_stat sim_throt_svc (UNIT *uptr)
 {
-uint32 delta_ms;
-double a_cps, d_cps;
+double delta_ns, a_cps, d_cps;
 
 if (sim_throt_type == SIM_THROT_SPC) {                  /* Non dynamic? */
     sim_throt_state = 2;                                /* force state */
@@ -1143,24 +1372,24 @@ if (sim_throt_type == SIM_THROT_SPC) {                  /* Non dynamic? */
 switch (sim_throt_state) {
 
     case 0:                                             /* take initial reading */
-        sim_throt_ms_start = sim_os_msec ();
+        sim_throt_ns_start = sim_os_nsec ();
         sim_throt_wait = SIM_THROT_WST;
         sim_throt_state = 1;                            /* next state */
         break;                                          /* reschedule */
 
     case 1:                                             /* take final reading */
-        sim_throt_ms_stop = sim_os_msec ();
-        delta_ms = sim_throt_ms_stop - sim_throt_ms_start;
-        if (delta_ms < SIM_THROT_MSMIN) {               /* not enough time? */
+        sim_throt_ns_stop = sim_os_nsec ();
+        delta_ns = (double) (sim_throt_ns_stop - sim_throt_ns_start);
+        if (delta_ns < (SIM_THROT_MSMIN * 1000000.0)) { /* not enough time? */
             if (sim_throt_wait >= 100000000) {          /* too many inst? */
                 sim_throt_state = 0;                    /* fails in 32b! */
                 return SCPE_OK;
                 }
             sim_throt_wait = sim_throt_wait * SIM_THROT_WMUL;
-            sim_throt_ms_start = sim_throt_ms_stop;
+            sim_throt_ns_start = sim_throt_ns_stop;
             }
         else {                                          /* long enough */
-            a_cps = ((double) sim_throt_wait) * 1000.0 / (double) delta_ms;
+            a_cps = ((double) sim_throt_wait) * 1000000000.0 / delta_ns;
             if (sim_throt_type == SIM_THROT_MCYC)       /* calc desired cps */
                 d_cps = (double) sim_throt_val * 1000000.0;
             else if (sim_throt_type == SIM_THROT_KCYC)
@@ -1177,7 +1406,7 @@ switch (sim_throt_state) {
                 sim_throt_sched ();                     /* start over */
                 return SCPE_OK;
                 }
-            sim_throt_ms_start = sim_throt_ms_stop;
+            sim_throt_ns_start = sim_throt_ns_stop;
             sim_throt_state = 2;
             sim_debug (DBG_THR, &sim_timer_dev, "sim_throt_svc() Throttle values a_cps = %f, d_cps = %f, wait = %d\n", 
                                                 a_cps, d_cps, sim_throt_wait);
@@ -1186,10 +1415,10 @@ switch (sim_throt_state) {
 
     case 2:                                             /* throttling */
         SIM_IDLE_MS_SLEEP (sim_throt_sleep_time);
-        delta_ms = sim_os_msec () - sim_throt_ms_start;
+        delta_ns = (double) (sim_os_nsec () - sim_throt_ns_start);
         if ((sim_throt_type != SIM_THROT_SPC) &&        /* when dynamic throttling */
-            (delta_ms >= 10000)) {                      /* recompute every 10 sec */
-            sim_throt_ms_start = sim_os_msec ();
+            (delta_ns >= 10000000000.0)) {              /* recompute every 10 sec */
+            sim_throt_ns_start = sim_os_nsec ();
             sim_throt_wait = SIM_THROT_WST;
             sim_throt_state = 1;                        /* next state */
             }
@@ -66,7 +66,8 @@ int clock_gettime(int clock_id, struct timespec *tp);
 
 
 #define SIM_NTIMERS     8                           /* # timers */
-#define SIM_TMAX        500                         /* max timer makeup */
+#define SIM_TMAX        500                         /* max timer makeup, ms */
+#define SIM_CAL_SMOOTH  4                           /* calibration smoothing */
 
 #define SIM_INITIAL_IPS 50000                       /* uncalibrated assumption */
                                                     /* about instructions per second */
@@ -76,6 +77,12 @@ int clock_gettime(int clock_id, struct timespec *tp);
 #define SIM_IDLE_STMIN  10                          /* min sec for stability */
 #define SIM_IDLE_STDFLT 20                          /* dft sec for stability */
 #define SIM_IDLE_STMAX  600                         /* max sec for stability */
+#define SIM_IDLE_MINUS  100                         /* min tickless sleep, usec */
+#if defined (__linux__)
+#define SIM_TICKLESS    1                           /* tickless idle available */
+#else
+#define SIM_TICKLESS    0
+#endif
 
 #define SIM_THROT_WINIT 1000                        /* cycles to skip */
 #define SIM_THROT_WST   10000                       /* initial wait */
@@ -102,6 +109,8 @@ void sim_rtcn_init_all (void);
 int32 sim_rtcn_calb (int32 ticksper, int32 tmr);
 int32 sim_rtc_init (int32 time);
 int32 sim_rtc_calb (int32 ticksper);
+void sim_rtcn_get_cal (int32 tmr, int32 *ticksper, int32 *currd);
+void sim_rtcn_set_cal (int32 tmr, int32 ticksper, int32 currd);
 t_stat sim_show_timers (FILE* st, DEVICE *dptr, UNIT* uptr, int32 val, char* desc);
 t_stat sim_show_clock_queues (FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, char *cptr);
 t_bool sim_idle (uint32 tmr, t_bool sin_cyc);
@@ -113,6 +122,10 @@ t_stat sim_show_idle (FILE *st, UNIT *uptr, int32 val, void *desc);
 void sim_throt_sched (void);
 void sim_throt_cancel (void);
 uint32 sim_os_msec (void);
+t_uint64 sim_os_nsec (void);
+#if SIM_TICKLESS
+t_bool sim_os_idle_until (t_uint64 deadline);
+#endif
 void sim_os_sleep (unsigned int sec);
 uint32 sim_os_ms_sleep (unsigned int msec);
 uint32 sim_os_ms_sleep_init (void);
@@ -2724,10 +2724,7 @@ pthread_t           sim_tmxr_poll_thread;          /* Polling Thread Id */
 pthread_t           sim_tmxr_serial_poll_thread;   /* Serial Polling Thread Id */
 pthread_cond_t      sim_tmxr_serial_startup_cond;
 #endif
-pthread_mutex_t     sim_tmxr_poll_lock;
-pthread_cond_t      sim_tmxr_poll_cond;
-pthread_cond_t      sim_tmxr_startup_cond;
-int32               sim_tmxr_poll_count = 0;
+pthread_cond_t      sim_tmxr_startup_cond;          /* poll lock, cond and count are in scp.c */
 t_bool              sim_tmxr_poll_running = FALSE;
 
 static void *
@@ -3336,6 +3333,38 @@ pthread_mutex_unlock (&sim_tmxr_poll_lock);
 #endif
 }
 
+/* Host descriptors on which input can arrive for the open multiplexers:
+   listening sockets, connected and connecting lines and serial ports.  The
+   simulator's idle sleep watches them so that input ends it.  Returns the
+   number stored in fds, at most max. */
+
+int tmxr_idle_fds (int *fds, int max)
+{
+int i, j, n = 0;
+TMXR *mp;
+TMLN *lp;
+
+for (i = 0; i < tmxr_open_device_count; ++i) {
+    mp = tmxr_open_devices[i];
+    if (mp->master && (n < max))
+        fds[n++] = (int) mp->master;
+    for (j = 0; j < mp->lines; ++j) {
+        lp = &mp->ldsc[j];
+        if (lp->sock && (n < max))
+            fds[n++] = (int) lp->sock;
+        if (lp->connecting && (n < max))
+            fds[n++] = (int) lp->connecting;
+        if (lp->master && (n < max))
+            fds[n++] = (int) lp->master;
+#if !defined(_WIN32) && !defined(VMS)
+        if (lp->serport && (n < max))
+            fds[n++] = (int) lp->serport;
+#endif
+        }
+    }
+return n;
+}
+
 static t_stat _tmxr_locate_line_send_expect (const char *cptr, SEND **snd, EXPECT **exp)
 {
 char gbuf[CBUFSIZE];
@@ -3635,7 +3664,7 @@ t_stat tmxr_clock_coschedule_tmr (UNIT *uptr, int32 tmr, int32 interval)
 #if defined(SIM_ASYNCH_IO) && defined(SIM_ASYNCH_MUX)
 if ((!(uptr->dynflags & UNIT_TM_POLL)) || 
     (!sim_asynch_enabled)) {
-    return sim_clock_coschedule (uptr, tmr, interval);
+    return sim_clock_coschedule_tmr (uptr, tmr, interval);
     }
 return SCPE_OK;
 #else